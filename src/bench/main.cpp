@@ -0,0 +1,538 @@
+// Microbenchmarks for the simulation hot paths. Builds synthetic worlds without SDL and times
+// each hot path in isolation. Every case runs a few untimed warmup rounds, then is timed over
+// several repetitions. Results are written as JSON lines, one object per benchmark, with the
+// fastest and the median repetition and the time per operation of the median one:
+//
+//   {"benchmark": "...", "stations": 1000, "ships": 1000, "iterations": 1000, "repetitions": 5, "min_ms": 1.20, "median_ms": 1.23, "ns_per_op": 1230.0}
+//
+// Usage: fourx_bench [--sizes 1000,10000,100000] [--seed <world seed>] [--warmup <rounds>]
+//                    [--repetitions <count>] [--output <file>]
+
+#include "../entityManager.hpp"
+#include "../marketSnapshot.hpp"
+#include "../pool.hpp"
+#include "../productionStation.hpp"
+#include "../ship.hpp"
+#include "../threadPool.hpp"
+#include "../tradeAssignment.hpp"
+#include "../utils.hpp"
+#include "../warfStation.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Synthetic world with as many ships as stations: half of the stations produce silicon, the
+// other half turn it into wafers, every station owns one freighter, plus a single warf station.
+// Prices in the game take thousands of ticks to converge, so the world is primed instead: wafer
+// stations get silicon delivered and silicon stations want wafers (which have a fixed price),
+// which gives every ship a trade to find right away.
+struct SyntheticWorld
+{
+    std::shared_ptr<EntityManager> entityManager;
+    // owned by the entity manager
+    std::vector<ProductionStation *> productionStations;
+    std::vector<Ship *> ships;
+};
+
+// What the Simulation does with the station timers of a tick, the other timers are dropped
+static void fireStationTimers(EntityManager &entityManager, std::vector<TimerEvent> &fired, CommandBuffer &commands)
+{
+    for (auto &event : fired)
+    {
+        auto stationTimer = std::get_if<timers::StationTimer>(&event);
+        if (stationTimer == nullptr)
+            continue;
+
+        Station *station = entityManager.getStation(stationTimer->station);
+        if (station != nullptr)
+        {
+            station->onTimer(stationTimer->id, commands);
+        }
+    }
+}
+
+static SyntheticWorld createWorld(size_t stationCount, uint64_t worldSeed)
+{
+    SyntheticWorld world;
+    world.entityManager = std::make_shared<EntityManager>();
+    world.entityManager->setWorldSeed(worldSeed);
+
+    auto random = world.entityManager->getRandom(0, utils::RandomPurpose::WorldGeneration);
+
+    // keep the station density of the game's 2000 stations on a 50k x 50k map
+    int mapSize = static_cast<int>(50000 * std::sqrt(stationCount / 2000.0));
+
+    for (size_t i = 0; i < stationCount; i++)
+    {
+        float x = static_cast<float>(random() % mapSize) - mapSize / 2.0f;
+        float y = static_cast<float>(random() % mapSize) - mapSize / 2.0f;
+
+        std::shared_ptr<ProductionStation> station;
+        if (i % 2 == 0)
+        {
+            station = ProductionStationPreset::createSiliconProductionStation(vec2f(x, y), "Silicon Production " + std::to_string(i), world.entityManager, nullptr, nullptr, nullptr);
+        }
+        else
+        {
+            station = ProductionStationPreset::createSiliconWaferProductionStation(vec2f(x, y), "Silicon Wafer Production " + std::to_string(i), world.entityManager, nullptr, nullptr, nullptr);
+        }
+
+        auto ship = ShipPreset::createFreighter(vec2f(x, y), nullptr);
+        world.entityManager->addShip(ship);
+        station->addShip(*ship);
+        world.entityManager->addStation(station);
+
+        world.productionStations.push_back(station.get());
+        world.ships.push_back(ship.get());
+    }
+
+    // delivers the silicon, its own cargo doesn't matter
+    auto supplyShip = ShipPreset::createFreighter(vec2f(0, 0), nullptr);
+
+    for (size_t i = 0; i < world.productionStations.size(); i++)
+    {
+        auto &station = world.productionStations[i];
+
+        // silicon production
+        if (i % 2 == 0)
+        {
+            station->setMaintenanceLevel(Ware::SiliconWafers, 1000);
+            continue;
+        }
+
+        station->acceptTrade(wares::TradeType::Buy, Ware::Silicon, 1000);
+        station->transferWares(*supplyShip, Ware::Silicon, -1000);
+    }
+
+    auto warfStation = makePooled<WarfStation>(vec2f(0, 0), "Warf Station", world.entityManager, nullptr, nullptr, nullptr);
+    warfStation->setMaintenanceLevel(Ware::SiliconWafers, 100000);
+    world.entityManager->addWarfStation(warfStation);
+
+    // run production for a while, so stations have something to offer
+    CommandBuffer commands;
+    std::vector<TimerEvent> fired;
+    for (int i = 0; i < 12; i++)
+    {
+        for (int tick = 0; tick < 60; tick++)
+        {
+            fired.clear();
+            world.entityManager->getTimers().advance(fired);
+            fireStationTimers(*world.entityManager, fired, commands);
+        }
+        commands.apply(world.entityManager);
+        world.entityManager->getStationComponents().updatePrices(world.entityManager->getOrderBook());
+    }
+
+    return world;
+}
+
+class BenchmarkWriter
+{
+public:
+    BenchmarkWriter(FILE *output, size_t warmupRounds, size_t repetitions)
+        : m_Output(output), m_WarmupRounds(warmupRounds), m_Repetitions(repetitions) {}
+
+    // Warmup rounds plus timed repetitions, for cases that need fresh input for every round
+    size_t getRounds() const
+    {
+        return m_WarmupRounds + m_Repetitions;
+    }
+
+    // Runs fn for every warmup round and repetition, only the repetitions are timed. setup(round)
+    // runs untimed before each of them (warmup rounds first).
+    template <typename Setup, typename Fn>
+    void run(const char *name, const SyntheticWorld &world, size_t iterations, Setup setup, Fn fn)
+    {
+        std::vector<double> seconds;
+        for (size_t round = 0; round < getRounds(); round++)
+        {
+            setup(round);
+
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            if (round >= m_WarmupRounds)
+            {
+                seconds.push_back(elapsed);
+            }
+        }
+
+        write(name, world, iterations, seconds);
+    }
+
+    template <typename Fn>
+    void run(const char *name, const SyntheticWorld &world, size_t iterations, Fn fn)
+    {
+        run(name, world, iterations, [](size_t) {}, fn);
+    }
+
+    // Times fn a single time without warmup, for cases that use up the world state they measure
+    template <typename Fn>
+    void runOnce(const char *name, const SyntheticWorld &world, size_t iterations, Fn fn)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        write(name, world, iterations, {elapsed});
+    }
+
+private:
+    void write(const char *name, const SyntheticWorld &world, size_t iterations, std::vector<double> seconds)
+    {
+        std::sort(seconds.begin(), seconds.end());
+        double median = seconds.size() % 2 == 1 ? seconds[seconds.size() / 2]
+                                                : (seconds[seconds.size() / 2 - 1] + seconds[seconds.size() / 2]) / 2;
+
+        fprintf(m_Output, "{\"benchmark\": \"%s\", \"stations\": %zu, \"ships\": %zu, \"iterations\": %zu, \"repetitions\": %zu, \"min_ms\": %.4f, \"median_ms\": %.4f, \"ns_per_op\": %.2f}\n",
+                name, world.entityManager->getStations().size(), world.entityManager->getShips().size(), iterations,
+                seconds.size(), seconds.front() * 1e3, median * 1e3, iterations > 0 ? median * 1e9 / iterations : 0.0);
+        fflush(m_Output);
+    }
+
+    FILE *m_Output;
+    size_t m_WarmupRounds;
+    size_t m_Repetitions;
+};
+
+static void runBenchmarks(BenchmarkWriter &writer, size_t stationCount, uint64_t worldSeed)
+{
+    fprintf(stderr, "building world with %zu stations...\n", stationCount);
+    SyntheticWorld world = createWorld(stationCount, worldSeed);
+    auto &entityManager = world.entityManager;
+    auto &stations = entityManager->getStations();
+
+    auto random = entityManager->getRandom(1, utils::RandomPurpose::WorldGeneration);
+
+    const size_t lookups = 10000;
+    std::vector<int> lookupIds;
+    lookupIds.reserve(lookups);
+    for (size_t i = 0; i < lookups; i++)
+    {
+        lookupIds.push_back(stations[random() % stations.size()]->getId());
+    }
+
+    // the results are checked after the timed rounds, outside of what is measured
+    size_t found = 0;
+    writer.run("EntityManager::getStationById", world, lookups, [&]
+               {
+        found = 0;
+        for (int id : lookupIds)
+        {
+            found += entityManager->getStationById(id) != nullptr;
+        } });
+    if (found != lookups)
+        fprintf(stderr, "getStationById: missing stations\n");
+
+    // every ware of every station dirty, as if all their stock had changed since the last tick
+    auto &stationComponents = entityManager->getStationComponents();
+    writer.run("Station::reevaluateTradeOffers", world, stations.size(), [&](size_t)
+               {
+        for (size_t slot = 0; slot < stationComponents.size(); slot++)
+        {
+            stationComponents.getMarket(slot).dirtyWares = static_cast<uint32_t>((uint64_t(1) << wares::WARE_COUNT) - 1);
+        } }, [&]
+               {
+        for (auto &station : stations)
+        {
+            station->reevaluateTradeOffers();
+        } });
+
+    // the arithmetic alone, then a whole interval including publishing the moved prices
+    writer.run("StationComponents::repriceOffers", world, stations.size(), [&]
+               { stationComponents.repriceOffers(); });
+
+    writer.run("StationComponents::updatePrices", world, stations.size(), [&]
+               { stationComponents.updatePrices(entityManager->getOrderBook()); });
+
+    // one production cycle worth of ticks (every module finishes once), the cost depends on the
+    // timers firing rather than on the number of stations
+    CommandBuffer commands;
+    std::vector<TimerEvent> firedTimers;
+    const size_t timerTicks = 300;
+    writer.run("TimerWheel::advance+station timers", world, timerTicks, [&]
+               {
+        for (size_t i = 0; i < timerTicks; i++)
+        {
+            firedTimers.clear();
+            entityManager->getTimers().advance(firedTimers);
+            fireStationTimers(*entityManager, firedTimers, commands);
+        } });
+    commands.apply(entityManager);
+
+    // a ship delivering silicon to every station: reserve the purchase, then hand the wares over
+    writer.run("Station::acceptTrade+transferWares", world, world.productionStations.size(), [&]
+               {
+        for (size_t i = 0; i < world.productionStations.size(); i++)
+        {
+            auto &station = world.productionStations[i];
+            station->acceptTrade(wares::TradeType::Buy, Ware::Silicon, 10);
+            station->transferWares(*world.ships[i], Ware::Silicon, -10);
+        } });
+
+    // every ship docks at the warf station, most of them have to queue and get a slot as the
+    // ships before them leave
+    auto &hub = *entityManager->getWarfStations()[0];
+    writer.run("Station::requestDock+undock (one hub)", world, world.ships.size(), [&]
+               {
+        for (auto &ship : world.ships)
+        {
+            hub.requestDock(*ship);
+        }
+        for (auto &ship : world.ships)
+        {
+            ship->leaveDock();
+        } });
+    if (hub.getDockQueueSize() != 0)
+        fprintf(stderr, "requestDock+undock: ships left in the queue\n");
+
+    const size_t bookQueries = 10000;
+    writer.run("OrderBook::getSellersBelow", world, bookQueries, [&]
+               {
+        auto &book = entityManager->getOrderBook()[Ware::SiliconWafers];
+        found = 0;
+        for (size_t i = 0; i < bookQueries; i++)
+        {
+            found += book.getSellersBelow(1.0f, 8).size();
+            found += book.getTotalQuantity(wares::TradeType::Buy) > 0;
+        } });
+    if (found == 0)
+        fprintf(stderr, "getSellersBelow: no sellers found\n");
+
+    const size_t purchaseChecks = 10;
+    writer.run("shipPurchaseCheck", world, purchaseChecks, [&]
+               {
+        for (size_t i = 0; i < purchaseChecks; i++)
+        {
+            shipPurchaseCheck(entityManager);
+        } });
+
+    // searches are expensive and commit a trade (after which the ship is busy), so only samples
+    // of ships are searched, a different sample every round. The samples share 200 ships, so
+    // the rounds don't use up the market the later ones search. Round r takes ships r, r + stride,
+    // r + 2 * stride, ... spread over the whole world; the stride is a multiple of the number of
+    // rounds, so no ship is searched twice.
+    const size_t rounds = writer.getRounds();
+    const size_t sampleSize = std::min<size_t>(std::max<size_t>(200 / rounds, 1), world.ships.size() / rounds);
+    const size_t sampleStride = std::max<size_t>(world.ships.size() / std::max<size_t>(sampleSize * rounds, 1), 1) * rounds;
+    auto takeSample = [&](size_t round, std::vector<Ship *> &sample)
+    {
+        sample.clear();
+        for (size_t i = round; i < world.ships.size() && sample.size() < sampleSize; i += sampleStride)
+        {
+            sample.push_back(world.ships[i]);
+        }
+    };
+
+    std::vector<Ship *> searchingShips;
+    takeSample(0, searchingShips);
+
+    ThreadPool threadPool(1);
+    MarketSnapshot snapshot;
+    writer.run("MarketSnapshot::capture", world, stations.size(), [&]
+               { snapshot.capture(*entityManager, threadPool); });
+
+    // only reads, the same sample every round
+    writer.run("Ship::findTrade", world, searchingShips.size(), [&]
+               {
+        found = 0;
+        for (auto &ship : searchingShips)
+        {
+            found += ship->findTrade(snapshot).has_value();
+        } });
+    if (found == 0)
+        fprintf(stderr, "findTrade: no trades found\n");
+
+    writer.run("Ship::searchForTrade", world, sampleSize, [&](size_t round)
+               { takeSample(round, searchingShips); }, [&]
+               {
+        for (auto &ship : searchingShips)
+        {
+            ship->searchForTrade();
+        } });
+
+    // every ship that is still idle gets a trade in one go, per idle ship. Afterwards they're all
+    // busy, so this is only timed once.
+    size_t idleShips = 0;
+    for (auto &ship : world.ships)
+    {
+        idleShips += ship->isIdle();
+    }
+    TradeAssigner tradeAssigner;
+    TradeAssignmentResult assignment;
+    writer.runOnce("TradeAssigner::assign", world, idleShips, [&]
+                   { assignment = tradeAssigner.assign(*entityManager, threadPool); });
+    if (assignment.assigned == 0)
+        fprintf(stderr, "TradeAssigner::assign: no trades assigned\n");
+
+    // shipyard churn: ships spawned through the command buffer (from the ship pool) and destroyed again
+    const size_t spawnedShips = 1000;
+    std::vector<ShipHandle> spawned;
+    writer.run("Ship spawn+despawn", world, spawnedShips, [&]
+               {
+        size_t firstSpawned = entityManager->getShips().size();
+        for (size_t i = 0; i < spawnedShips; i++)
+        {
+            commands.spawnShip({vec2f(0, 0), 600, 100, 1.0f, world.productionStations[0]->getHandle(), nullptr});
+        }
+        commands.apply(entityManager);
+
+        spawned.clear();
+        for (size_t i = firstSpawned; i < entityManager->getShips().size(); i++)
+        {
+            spawned.push_back(entityManager->getShips()[i]->getHandle());
+        }
+        for (ShipHandle handle : spawned)
+        {
+            entityManager->removeShip(handle);
+        } });
+
+    // every ship flying to a spot far enough away that nobody arrives during the benchmark
+    auto &kinematics = entityManager->getShipKinematics();
+    for (auto &ship : world.ships)
+    {
+        vec2f position = ship->getPosition();
+        kinematics.setTarget(ship, position, vec2f(position.x + 1e6f, position.y - 1e6f), 100.0f);
+    }
+
+    const size_t kinematicsSteps = 100;
+    std::vector<Ship *> arrivals;
+    writer.run("ShipKinematics::step", world, kinematicsSteps * kinematics.size(), [&]
+               {
+        for (size_t i = 0; i < kinematicsSteps; i++)
+        {
+            kinematics.step(1.0f / 60.0f, arrivals);
+        } });
+
+    // the closed-form solver on its own, against targets flying in every direction
+    const size_t interceptSolves = 100000;
+    writer.run("combat::solveInterceptTime", world, interceptSolves, [&]
+               {
+        found = 0;
+        for (size_t i = 0; i < interceptSolves; i++)
+        {
+            float angle = static_cast<float>(i) * 0.01f;
+            vec2f offset(static_cast<float>(i % 1000) - 500.0f, 300.0f);
+            vec2f targetVelocity(100.0f * std::cos(angle), 100.0f * std::sin(angle));
+            found += combat::solveInterceptTime(offset, targetVelocity, 150.0f).has_value();
+        } });
+    if (found != interceptSolves)
+        fprintf(stderr, "solveInterceptTime: a faster pursuer missed\n");
+
+    // equal speeds, head-on, the two meet halfway after 300 / (2 * 100) seconds
+    size_t equalSpeedMisses = 0;
+    for (size_t i = 1; i < 3600; i++)
+    {
+        float angle = static_cast<float>(i) * 0.1f * 3.14159265f / 180.0f;
+        vec2f direction(std::cos(angle), std::sin(angle));
+        auto time = combat::solveInterceptTime(direction * 300.0f, direction * -100.0f, 100.0f);
+        if (!time.has_value() || std::fabs(time.value() - 1.5f) > 0.015f)
+            equalSpeedMisses++;
+    }
+    if (equalSpeedMisses > 0)
+        fprintf(stderr, "solveInterceptTime: %zu equal speed head-on pursuits missed\n", equalSpeedMisses);
+
+    // every other ship goes after its neighbour, most are far apart so this is mostly pursuit
+    auto &combat = entityManager->getCombat();
+    for (size_t i = 0; i + 1 < world.ships.size(); i += 2)
+    {
+        world.ships[i]->attack(*world.ships[i + 1]);
+    }
+    const size_t engagements = combat.getEngagementCount();
+    writer.run("CombatSystem::resolve", world, engagements, [&]
+               { combat.resolve(*entityManager, 1.0f / 60.0f); });
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<size_t> sizes = {1000, 10000, 100000};
+    uint64_t worldSeed = 1;
+    const char *outputPath = nullptr;
+    long warmupRounds = 1;
+    long repetitions = 5;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc)
+        {
+            sizes.clear();
+            std::string list = argv[++i];
+            size_t start = 0;
+            while (start < list.size())
+            {
+                size_t end = list.find(',', start);
+                if (end == std::string::npos)
+                    end = list.size();
+                sizes.push_back(strtoull(list.substr(start, end - start).c_str(), nullptr, 10));
+                start = end + 1;
+            }
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            worldSeed = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+        {
+            warmupRounds = strtol(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc)
+        {
+            repetitions = strtol(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+        {
+            outputPath = argv[++i];
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [--sizes 1000,10000,100000] [--seed <world seed>] [--warmup <rounds>] [--repetitions <count>] [--output <file>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (warmupRounds < 0)
+    {
+        fprintf(stderr, "--warmup must not be negative\n");
+        return 1;
+    }
+
+    if (repetitions <= 0)
+    {
+        fprintf(stderr, "--repetitions must be positive\n");
+        return 1;
+    }
+
+    FILE *output = stdout;
+    if (outputPath)
+    {
+        output = fopen(outputPath, "w");
+        if (!output)
+        {
+            fprintf(stderr, "Failed to open %s\n", outputPath);
+            return 1;
+        }
+    }
+
+    BenchmarkWriter writer(output, static_cast<size_t>(warmupRounds), static_cast<size_t>(repetitions));
+    for (size_t size : sizes)
+    {
+        if (size < 2)
+            continue;
+
+        runBenchmarks(writer, size, worldSeed);
+    }
+
+    if (output != stdout)
+    {
+        fclose(output);
+    }
+
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include "combat.hpp"
+#include "entityManager.hpp"
+#include "metrics.hpp"
+#include "ship.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace combat
+{
+
+    std::optional<float> solveInterceptTime(vec2f offset, vec2f targetVelocity, float speed)
+    {
+        // (v.v - s^2) t^2 + 2 (o.v) t + o.o = 0
+        float targetSpeedSquared = targetVelocity.x * targetVelocity.x + targetVelocity.y * targetVelocity.y;
+        float a = targetSpeedSquared - speed * speed;
+        float b = 2.0f * (offset.x * targetVelocity.x + offset.y * targetVelocity.y);
+        float c = offset.x * offset.x + offset.y * offset.y;
+
+        if (c == 0.0f)
+            return 0.0f;
+
+        // same speed, the quadratic term drops out. Relative to the speeds, since rounding leaves
+        // a small but far from zero a for equal speeds on anything but the axes
+        if (std::fabs(a) <= 1e-5f * std::max(targetSpeedSquared, speed * speed))
+        {
+            if (b >= 0.0f)
+                return std::nullopt;
+
+            return -c / b;
+        }
+
+        float discriminant = b * b - 4.0f * a * c;
+        if (discriminant < 0.0f)
+            return std::nullopt;
+
+        // the stable form, (-b +- root) / 2a cancels badly when a is small. q can't be zero,
+        // that would take b == 0 and root == 0, so c == 0
+        float root = std::sqrt(discriminant);
+        float q = -0.5f * (b + std::copysign(root, b));
+        float t1 = q / a;
+        float t2 = c / q;
+
+        // a < 0 (the pursuer is faster) gives exactly one positive root, a > 0 zero or two
+        float t = std::min(t1, t2);
+        if (t < 0.0f)
+            t = std::max(t1, t2);
+        if (t < 0.0f)
+            return std::nullopt;
+
+        return t;
+    }
+
+}
+
+void CombatSystem::engage(ShipHandle attacker, ShipHandle target)
+{
+    m_Engagements.push_back(Engagement{attacker, target});
+}
+
+void CombatSystem::destroy(ShipHandle ship)
+{
+    m_Destroyed.push_back(ship);
+}
+
+void CombatSystem::resolve(EntityManager &entityManager, float dt)
+{
+    // one stream for the whole batch, drawn from in engagement order
+    auto random = entityManager.getRandom(0, utils::RandomPurpose::Combat);
+
+    size_t remaining = 0;
+    for (size_t i = 0; i < m_Engagements.size(); i++)
+    {
+        Engagement engagement = m_Engagements[i];
+
+        Ship *attacker = entityManager.getShip(engagement.attacker);
+        Ship *target = entityManager.getShip(engagement.target);
+
+        // one side is gone or already lost, the fight is over
+        if (attacker == nullptr || target == nullptr || attacker->getHullHealth() <= 0 || target->getHullHealth() <= 0)
+            continue;
+
+        // the attacker took a trade in the meantime and broke off
+        if (!attacker->canFight())
+            continue;
+
+        if (attacker->intercept(*target, dt))
+        {
+            // one hit per tick, either side may land it
+            if (random() % 2 == 0)
+            {
+                target->doDamage(attacker->getWeaponAttack());
+            }
+            else
+            {
+                attacker->doDamage(target->getWeaponAttack());
+            }
+
+            metrics::combatHits.add();
+        }
+
+        m_Engagements[remaining++] = engagement;
+    }
+    m_Engagements.resize(remaining);
+
+    for (ShipHandle ship : m_Destroyed)
+    {
+        if (entityManager.getShip(ship) == nullptr)
+            continue;
+
+        entityManager.removeShip(ship);
+        metrics::shipsDestroyed.add();
+    }
+    m_Destroyed.clear();
+}
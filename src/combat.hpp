@@ -0,0 +1,53 @@
+#pragma once
+
+#include "slotMap.hpp"
+#include "vec.hpp"
+
+#include <optional>
+#include <vector>
+
+class EntityManager;
+
+// Ships fire once they're this close to their target (plus the distance they cover in a tick)
+#define COMBAT_RANGE 5.0f
+
+namespace combat
+{
+
+    // Earliest time at which a ship flying at speed from the origin can meet a target at offset
+    // moving with targetVelocity. Solves |offset + targetVelocity * t| = speed * t, a quadratic in
+    // t, instead of sampling. Empty if the target is faster and getting away.
+    std::optional<float> solveInterceptTime(vec2f offset, vec2f targetVelocity, float speed);
+
+}
+
+// Every fight in the world. Ships start a fight with Ship::attack, which only records the
+// engagement. Once per tick resolve goes over all of them in one batch: attackers out of range
+// steer towards their intercept point, fights in range exchange one hit. Ships destroyed along
+// the way are only removed at the end of resolve, so nothing is removed while it's being iterated.
+class CombatSystem
+{
+public:
+    void engage(ShipHandle attacker, ShipHandle target);
+
+    // Removes the ship at the end of the next resolve
+    void destroy(ShipHandle ship);
+
+    // Has to be called at a point where ships can be removed, e.g. after all ships moved
+    void resolve(EntityManager &entityManager, float dt);
+
+    size_t getEngagementCount() const
+    {
+        return m_Engagements.size();
+    }
+
+private:
+    struct Engagement
+    {
+        ShipHandle attacker;
+        ShipHandle target;
+    };
+
+    std::vector<Engagement> m_Engagements;
+    std::vector<ShipHandle> m_Destroyed;
+};
@@ -0,0 +1,31 @@
+#include "commandBuffer.hpp"
+#include "entityManager.hpp"
+#include "pool.hpp"
+#include "ship.hpp"
+
+#include <stdexcept>
+
+void CommandBuffer::spawnShip(commands::SpawnShip spawn)
+{
+    m_Commands.push_back(spawn);
+}
+
+void CommandBuffer::apply(std::shared_ptr<EntityManager> entityManager)
+{
+    for (auto &command : m_Commands)
+    {
+        if (std::holds_alternative<commands::SpawnShip>(command))
+        {
+            auto &spawn = std::get<commands::SpawnShip>(command);
+            auto ship = makePooled<Ship>(spawn.position, spawn.maxSpeed, spawn.cargoCapacity, spawn.weaponAttack, spawn.renderer);
+            ship->claim(spawn.owner);
+            entityManager->addShip(ship);
+        }
+        else
+        {
+            throw std::runtime_error("Unknown command type");
+        }
+    }
+
+    m_Commands.clear();
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "slotMap.hpp"
+#include "vec.hpp"
+
+#include <SDL2/SDL.h>
+
+#include <variant>
+#include <vector>
+#include <memory>
+
+class EntityManager;
+
+// Side effects on the EntityManager that can't be applied while the stations are being iterated,
+// e.g. ships spawned by station timers. They are recorded here instead and applied on the main
+// thread once every timer of the tick has fired.
+namespace commands
+{
+
+    // Ships are only constructed when this is applied, so the ship list doesn't change while the stations are iterated
+    struct SpawnShip
+    {
+        vec2f position;
+        float maxSpeed;
+        float cargoCapacity;
+        float weaponAttack;
+        StationHandle owner;
+        SDL_Renderer *renderer;
+    };
+
+}
+
+typedef std::variant<commands::SpawnShip> Command;
+
+class CommandBuffer
+{
+public:
+    void spawnShip(commands::SpawnShip spawn);
+
+    // Applies the recorded commands in the order they were recorded and clears the buffer.
+    void apply(std::shared_ptr<EntityManager> entityManager);
+
+    bool empty() const
+    {
+        return m_Commands.empty();
+    }
+
+private:
+    std::vector<Command> m_Commands;
+};
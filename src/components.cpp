@@ -0,0 +1,216 @@
+#include "components.hpp"
+#include "config.hpp"
+#include "orderBook.hpp"
+#include "ship.hpp"
+#include "station.hpp"
+
+#include <algorithm>
+
+// SSE is part of x86-64, everything else (or a build with it turned off) uses the scalar loop
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STATION_PRICING_SSE 1
+#include <emmintrin.h>
+#endif
+
+// the repricing pass cubes the level difference with two multiplies
+#if PRICE_CHANGE_EXPONENT != 3
+#error "StationComponents::repriceOffers assumes PRICE_CHANGE_EXPONENT is 3"
+#endif
+
+void ShipComponents::add(Ship *ship)
+{
+    if (ship->m_Components != nullptr)
+        return;
+
+    ship->m_Components = this;
+    ship->m_ComponentIndex = m_Ships.size();
+
+    m_Bodies.push_back(ship->m_Body);
+    m_Ships.push_back(ship);
+}
+
+void ShipComponents::remove(Ship *ship)
+{
+    if (ship->m_Components != this)
+        return;
+
+    size_t slot = ship->m_ComponentIndex;
+
+    // the ship may still be looked at after it's gone (e.g. its hull health after a fight)
+    ship->m_Body = m_Bodies[slot];
+    ship->m_Components = nullptr;
+
+    size_t last = m_Ships.size() - 1;
+    if (slot != last)
+    {
+        m_Bodies[slot] = m_Bodies[last];
+        m_Ships[slot] = m_Ships[last];
+        m_Ships[slot]->m_ComponentIndex = slot;
+    }
+
+    m_Bodies.pop_back();
+    m_Ships.pop_back();
+}
+
+ShipComponents::~ShipComponents()
+{
+    // ships can outlive the manager (stations hold on to the ships they own)
+    while (!m_Ships.empty())
+    {
+        remove(m_Ships.back());
+    }
+}
+
+size_t StationComponents::add(Station *station, vec2f position)
+{
+    m_Positions.push_back(position);
+    m_Markets.emplace_back();
+    m_RenderData.emplace_back();
+    m_Stations.push_back(station);
+
+    for (auto &pricing : m_Pricing)
+    {
+        pricing.prices.push_back(0);
+        pricing.sides.push_back(0);
+        pricing.levelDiffs.push_back(0);
+    }
+
+    return m_Stations.size() - 1;
+}
+
+void StationComponents::remove(size_t slot)
+{
+    size_t last = m_Stations.size() - 1;
+    if (slot != last)
+    {
+        m_Positions[slot] = m_Positions[last];
+        m_Markets[slot] = std::move(m_Markets[last]);
+        m_RenderData[slot] = m_RenderData[last];
+        m_Stations[slot] = m_Stations[last];
+        m_Stations[slot]->m_ComponentIndex = slot;
+
+        for (auto &pricing : m_Pricing)
+        {
+            pricing.prices[slot] = pricing.prices[last];
+            pricing.sides[slot] = pricing.sides[last];
+            pricing.levelDiffs[slot] = pricing.levelDiffs[last];
+        }
+    }
+
+    m_Positions.pop_back();
+    m_Markets.pop_back();
+    m_RenderData.pop_back();
+    m_Stations.pop_back();
+
+    for (auto &pricing : m_Pricing)
+    {
+        pricing.prices.pop_back();
+        pricing.sides.pop_back();
+        pricing.levelDiffs.pop_back();
+    }
+}
+
+void StationComponents::updatePrices(OrderBook &orderBook)
+{
+    repriceOffers();
+    publishPrices(orderBook);
+}
+
+// Every open offer moves by
+//   range * steps * (min(a * (-levelDiff)^3, MAX_ALLOWED_PRICE_CHANGE_PERCENTAGE) + side * 0.00001)
+// where a scales the change to MAX_EXPECTED_PRODUCT_COUNT (maintenance levels can be 0) and the
+// small constant step pushes sellers up and buyers down, and is then clamped to the ware's price
+// range. Offers without quantity left keep their price.
+void StationComponents::repriceOffers()
+{
+    const float steps = PRICE_UPDATE_INTERVAL * PRICE_STEP_REFERENCE_RATE;
+    const float a = static_cast<float>(MAX_ALLOWED_PRICE_CHANGE_PERCENTAGE / (static_cast<double>(MAX_EXPECTED_PRODUCT_COUNT) * MAX_EXPECTED_PRODUCT_COUNT * MAX_EXPECTED_PRODUCT_COUNT));
+    const float maxChange = static_cast<float>(MAX_ALLOWED_PRICE_CHANGE_PERCENTAGE);
+    const float constantStep = 0.00001f;
+
+    size_t count = m_Stations.size();
+
+    for (size_t w = 0; w < wares::WARE_COUNT; w++)
+    {
+        const wares::WareDetails &details = wares::wareDetails.get(static_cast<wares::Ware>(w));
+        const float minPrice = details.min_price;
+        const float maxPrice = details.max_price;
+        const float range = maxPrice - minPrice;
+
+        float *prices = m_Pricing[w].prices.data();
+        const float *sides = m_Pricing[w].sides.data();
+        const float *levelDiffs = m_Pricing[w].levelDiffs.data();
+
+        size_t i = 0;
+
+#ifdef STATION_PRICING_SSE
+        const __m128 aVector = _mm_set1_ps(a);
+        const __m128 maxChangeVector = _mm_set1_ps(maxChange);
+        const __m128 constantStepVector = _mm_set1_ps(constantStep);
+        const __m128 stepsVector = _mm_set1_ps(steps);
+        const __m128 rangeVector = _mm_set1_ps(range);
+        const __m128 minPriceVector = _mm_set1_ps(minPrice);
+        const __m128 maxPriceVector = _mm_set1_ps(maxPrice);
+        const __m128 zero = _mm_setzero_ps();
+
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 price = _mm_loadu_ps(prices + i);
+            __m128 side = _mm_loadu_ps(sides + i);
+            __m128 shortage = _mm_sub_ps(zero, _mm_loadu_ps(levelDiffs + i));
+
+            __m128 change = _mm_mul_ps(aVector, _mm_mul_ps(_mm_mul_ps(shortage, shortage), shortage));
+            change = _mm_add_ps(_mm_min_ps(change, maxChangeVector), _mm_mul_ps(side, constantStepVector));
+
+            __m128 moved = _mm_add_ps(price, _mm_mul_ps(rangeVector, _mm_mul_ps(change, stepsVector)));
+            moved = _mm_max_ps(_mm_min_ps(moved, maxPriceVector), minPriceVector);
+
+            __m128 open = _mm_cmpneq_ps(side, zero);
+            _mm_storeu_ps(prices + i, _mm_or_ps(_mm_and_ps(open, moved), _mm_andnot_ps(open, price)));
+        }
+#endif
+
+        // the same math one offer at a time, for the stations that don't fill a vector (or without SSE)
+        for (; i < count; i++)
+        {
+            if (sides[i] == 0)
+                continue;
+
+            float shortage = -levelDiffs[i];
+            float change = std::min(a * (shortage * shortage * shortage), maxChange) + sides[i] * constantStep;
+            float moved = prices[i] + range * (change * steps);
+            prices[i] = std::max(std::min(moved, maxPrice), minPrice);
+        }
+    }
+}
+
+// Copies the prices that moved back into the offers, in slot order so the order book sees the
+// same sequence of updates every run
+void StationComponents::publishPrices(OrderBook &orderBook)
+{
+    size_t count = m_Stations.size();
+
+    for (size_t w = 0; w < wares::WARE_COUNT; w++)
+    {
+        auto ware = static_cast<wares::Ware>(w);
+        auto &book = orderBook[ware];
+        const float *prices = m_Pricing[w].prices.data();
+        const float *sides = m_Pricing[w].sides.data();
+
+        for (size_t i = 0; i < count; i++)
+        {
+            if (sides[i] == 0)
+                continue;
+
+            wares::TradeType type = sides[i] > 0 ? wares::TradeType::Sell : wares::TradeType::Buy;
+            auto &offers = type == wares::TradeType::Sell ? m_Markets[i].sellOffers : m_Markets[i].buyOffers;
+            wares::Offer &offer = offers[ware];
+
+            if (offer.price == prices[i])
+                continue;
+
+            offer.price = prices[i];
+            book.setOffer(type, m_Stations[i]->getId(), m_Stations[i], offer.price, offer.quantity);
+        }
+    }
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "vec.hpp"
+#include "wares.hpp"
+
+#include <SDL2/SDL.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class OrderBook;
+class Ship;
+class Station;
+
+// Dense component storage for ships and stations. Every entity owns one slot in each array of its
+// kind, and the Ship and Station classes are facades over their slot, so gameplay code keeps
+// calling methods on the objects while loops over all entities (movement, pricing, snapshots)
+// walk contiguous arrays instead of chasing a pointer per entity. Removing an entity moves the
+// last slot into its place, so slots (unlike ids) aren't stable.
+
+// Where a ship is and how it's doing, always used together by movement and rendering
+struct ShipBody
+{
+    vec2f position;
+    // position at the start of the last tick, used to interpolate between simulation steps when rendering
+    vec2f previousPosition;
+    // unit vector in the direction the ship last moved
+    vec2f heading = vec2f(1, 0);
+    float hullHealth = 100.0f;
+};
+
+// Ships get a slot when they're added to the EntityManager. Until then (and after they're
+// removed) they keep their body themselves.
+class ShipComponents
+{
+public:
+    ShipComponents() = default;
+    ShipComponents(const ShipComponents &) = delete;
+    ShipComponents &operator=(const ShipComponents &) = delete;
+    ~ShipComponents();
+
+    void add(Ship *ship);
+    void remove(Ship *ship);
+
+    size_t size() const
+    {
+        return m_Ships.size();
+    }
+
+    ShipBody &getBody(size_t slot)
+    {
+        return m_Bodies[slot];
+    }
+    const ShipBody &getBody(size_t slot) const
+    {
+        return m_Bodies[slot];
+    }
+
+    const std::vector<ShipBody> &getBodies() const
+    {
+        return m_Bodies;
+    }
+    const std::vector<Ship *> &getShips() const
+    {
+        return m_Ships;
+    }
+
+private:
+    std::vector<ShipBody> m_Bodies;
+    std::vector<Ship *> m_Ships;
+};
+
+// Offers of a station and the stock they're based on
+struct StationMarket
+{
+    wares::WareArray<wares::Offer> sellOffers;
+    wares::WareArray<wares::Offer> buyOffers;
+    // Wares with a buy/sell offer that still has quantity left, one bit per ware
+    uint32_t openBuyOffers = 0;
+    uint32_t openSellOffers = 0;
+
+    wares::WareArray<int> maintenanceLevels;
+    wares::WareArray<int> inventory;
+    // Virtual inventory keeping track of the wares that the station is planning to buy
+    wares::WareArray<int> buyReservations;
+    // Virtual inventory keeping track of the wares that the station is planning to sell
+    wares::WareArray<int> sellReservations;
+
+    // Wares whose inventory, reservations or maintenance level changed since the last evaluation, one bit per ware
+    uint32_t dirtyWares = 0;
+};
+
+// What the repricing pass needs of one ware, one entry per station slot. Stations keep these up
+// to date whenever they publish an offer or reevaluate their stock.
+struct WarePricing
+{
+    std::vector<float> prices;
+    // +1 for an open sell offer, -1 for an open buy offer, 0 without an open offer
+    std::vector<float> sides;
+    // inventory plus buy reservations minus the maintenance level
+    std::vector<float> levelDiffs;
+};
+
+struct StationRenderData
+{
+    SDL_Texture *texture = nullptr;
+    SDL_Texture *nameTexture = nullptr;
+    int nameTextWidth = 0, nameTextHeight = 0;
+
+    // where the station was last drawn, for mouse picking
+    int onScreenX = 0, onScreenY = 0;
+    int onScreenWidth = 0, onScreenHeight = 0;
+};
+
+// Stations get their slot when they're constructed and give it back when they're destroyed.
+// Stations are only constructed, destroyed and ticked on the main thread; the parallel readers
+// (MarketSnapshot::capture) run while nothing writes.
+class StationComponents
+{
+public:
+    StationComponents() = default;
+    StationComponents(const StationComponents &) = delete;
+    StationComponents &operator=(const StationComponents &) = delete;
+
+    size_t add(Station *station, vec2f position);
+    void remove(size_t slot);
+
+    size_t size() const
+    {
+        return m_Stations.size();
+    }
+
+    vec2f &getPosition(size_t slot)
+    {
+        return m_Positions[slot];
+    }
+    StationMarket &getMarket(size_t slot)
+    {
+        return m_Markets[slot];
+    }
+    StationRenderData &getRenderData(size_t slot)
+    {
+        return m_RenderData[slot];
+    }
+
+    void setOpenOffer(size_t slot, wares::Ware ware, float side, float price)
+    {
+        m_Pricing[ware].sides[slot] = side;
+        m_Pricing[ware].prices[slot] = price;
+    }
+    void setLevelDiff(size_t slot, wares::Ware ware, int levelDiff)
+    {
+        m_Pricing[ware].levelDiffs[slot] = static_cast<float>(levelDiff);
+    }
+
+    // Moves the price of every open offer of every station by one PRICE_UPDATE_INTERVAL and
+    // publishes the prices that changed to the stations' offers and the order book.
+    void updatePrices(OrderBook &orderBook);
+    // The arithmetic half of updatePrices, one pass per ware over the pricing columns
+    void repriceOffers();
+
+    const std::vector<vec2f> &getPositions() const
+    {
+        return m_Positions;
+    }
+    const std::vector<StationMarket> &getMarkets() const
+    {
+        return m_Markets;
+    }
+    const std::vector<Station *> &getStations() const
+    {
+        return m_Stations;
+    }
+
+private:
+    std::vector<vec2f> m_Positions;
+    std::vector<StationMarket> m_Markets;
+    std::vector<StationRenderData> m_RenderData;
+    std::vector<Station *> m_Stations;
+    std::array<WarePricing, wares::WARE_COUNT> m_Pricing;
+
+    void publishPrices(OrderBook &orderBook);
+};
@@ -2,4 +2,11 @@
 
 #define MAX_ALLOWED_PRICE_CHANGE_PERCENTAGE 0.1
 #define PRICE_CHANGE_EXPONENT 3
-#define MAX_EXPECTED_PRODUCT_COUNT 10000
\ No newline at end of file
+#define MAX_EXPECTED_PRODUCT_COUNT 10000
+// Stations move the prices of their open offers at this interval (simulated seconds)
+#define PRICE_UPDATE_INTERVAL 1.0f
+// The price steps above were tuned for one update per 60 Hz frame, they're scaled to keep that rate per second
+#define PRICE_STEP_REFERENCE_RATE 60.0f
+
+// The simulation always advances in steps of this size (in seconds), independent of the frame rate
+#define SIM_TIMESTEP (1.0f / 60.0f)
@@ -0,0 +1,58 @@
+#include "docking.hpp"
+#include "wares.hpp"
+
+#include <bitset>
+#include <stdexcept>
+
+static_assert(DOCKING_SLOTS <= 32, "free docking slots are kept in a 32 bit mask");
+
+uint32_t DockingBay::occupy(ShipHandle ship)
+{
+    uint32_t slot = static_cast<uint32_t>(wares::lowestBitIndex(m_FreeSlots));
+    m_FreeSlots &= ~(1u << slot);
+    m_Slots[slot] = ship;
+    return slot;
+}
+
+uint32_t DockingBay::request(ShipHandle ship, uint64_t tick)
+{
+    // ships already waiting go first
+    if (m_FreeSlots != 0 && m_Queue.empty())
+    {
+        return occupy(ship);
+    }
+
+    m_Queue.push_back(WaitingShip{ship, tick});
+    return NO_SLOT;
+}
+
+void DockingBay::release(uint32_t slot, ShipHandle ship)
+{
+    if (slot >= DOCKING_SLOTS || m_Slots[slot] != ship)
+    {
+        throw std::runtime_error("Ship not docked in this slot");
+    }
+
+    m_Slots[slot] = ShipHandle();
+    m_FreeSlots |= 1u << slot;
+}
+
+bool DockingBay::admitNext(uint64_t tick, ShipHandle &ship, uint32_t &slot, uint64_t &waitedTicks)
+{
+    if (m_FreeSlots == 0 || m_Queue.empty())
+        return false;
+
+    WaitingShip waiting = m_Queue.front();
+    m_Queue.pop_front();
+
+    waitedTicks = tick - waiting.since;
+
+    ship = waiting.ship;
+    slot = occupy(ship);
+    return true;
+}
+
+size_t DockingBay::getDockedCount() const
+{
+    return DOCKING_SLOTS - std::bitset<32>(m_FreeSlots).count();
+}
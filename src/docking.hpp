@@ -0,0 +1,50 @@
+#pragma once
+
+#include "slotMap.hpp"
+
+#include <cstdint>
+#include <deque>
+
+// Docking slots per station
+#define DOCKING_SLOTS 5
+
+// The docking slots of a station and the ships waiting for one. The slots are a fixed array with
+// a bit per free slot, docked ships know their slot, so docking and leaving are O(1). Ships that
+// find every slot taken wait in a FIFO queue and get the next slot that frees up (see admitNext).
+class DockingBay
+{
+public:
+    static const uint32_t NO_SLOT = UINT32_MAX;
+
+    // The slot the ship docked at, or NO_SLOT if it has to wait in the queue
+    uint32_t request(ShipHandle ship, uint64_t tick);
+
+    // Frees the slot the ship docked at
+    void release(uint32_t slot, ShipHandle ship);
+
+    // Puts the next waiting ship into a free slot and tells how many ticks it waited. False if no
+    // slot is free or no ship is waiting. The waiting ship may have been removed in the meantime,
+    // then the slot has to be released again.
+    bool admitNext(uint64_t tick, ShipHandle &ship, uint32_t &slot, uint64_t &waitedTicks);
+
+    size_t getDockedCount() const;
+
+    size_t getQueueLength() const
+    {
+        return m_Queue.size();
+    }
+
+private:
+    struct WaitingShip
+    {
+        ShipHandle ship;
+        uint64_t since;
+    };
+
+    uint32_t occupy(ShipHandle ship);
+
+    ShipHandle m_Slots[DOCKING_SLOTS];
+    uint32_t m_FreeSlots = (1u << DOCKING_SLOTS) - 1;
+
+    std::deque<WaitingShip> m_Queue;
+};
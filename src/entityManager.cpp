@@ -53,23 +53,43 @@
 
 void EntityManager::addShip(std::shared_ptr<Ship> ship)
 {
-    ship->setManager(shared_from_this());
-    m_Ships.push_back(ship);
+    ship->setManager(this);
+    ship->setHandle(m_Ships.insert(ship), generateId());
+    m_ShipComponents.add(ship.get());
+    // needs the handle, so owned ships start checking for trades only now
+    ship->scheduleTradeCheck();
 }
 
-void EntityManager::removeShip(std::shared_ptr<Ship> ship)
+void EntityManager::removeShip(ShipHandle handle)
 {
-    m_Ships.erase(std::remove(m_Ships.begin(), m_Ships.end(), ship), m_Ships.end());
+    Ship *ship = getShip(handle);
+    if (ship == nullptr)
+        return;
+
+    // frees the slot for the next ship waiting there
+    ship->leaveDock();
+    m_ShipKinematics.remove(ship);
+    m_ShipComponents.remove(ship);
+    m_Ships.remove(handle);
 }
 
 void EntityManager::addStation(std::shared_ptr<Station> station)
 {
-    m_Stations.push_back(station);
+    m_StationGrid.insert(station->getId(), station->getPosition(), station.get());
+    m_Stations.insert(station->getHandle(), station);
+    m_StationHandlesById[station->getId()] = station->getHandle();
 }
 
-void EntityManager::removeStation(std::shared_ptr<Station> station)
+void EntityManager::removeStation(StationHandle handle)
 {
-    m_Stations.erase(std::remove(m_Stations.begin(), m_Stations.end(), station), m_Stations.end());
+    Station *station = getStation(handle);
+    if (station == nullptr)
+        return;
+
+    m_StationGrid.remove(station->getId(), station->getPosition());
+    m_OrderBook.removeStation(station->getId());
+    m_StationHandlesById.erase(station->getId());
+    m_Stations.remove(handle);
 }
 
 void EntityManager::addWarfStation(std::shared_ptr<WarfStation> warfStation)
@@ -81,18 +101,5 @@ void EntityManager::addWarfStation(std::shared_ptr<WarfStation> warfStation)
 void EntityManager::removeWarfStation(std::shared_ptr<WarfStation> warfStation)
 {
     m_WarfStations.erase(std::remove(m_WarfStations.begin(), m_WarfStations.end(), warfStation), m_WarfStations.end());
-    this->removeStation(warfStation);
-}
-
-std::shared_ptr<Station> EntityManager::getStationById(int id)
-{
-    for (auto &station : m_Stations)
-    {
-        if (station->getId() == id)
-        {
-            return station;
-        }
-    }
-
-    return nullptr;
+    this->removeStation(warfStation->getHandle());
 }
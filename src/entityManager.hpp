@@ -1,5 +1,16 @@
 #pragma once
 
+#include "combat.hpp"
+#include "components.hpp"
+#include "orderBook.hpp"
+#include "random.hpp"
+#include "slotMap.hpp"
+#include "shipKinematics.hpp"
+#include "spatialGrid.hpp"
+#include "timerWheel.hpp"
+
+#include <cstdint>
+#include <unordered_map>
 #include <vector>
 #include <memory>
 #include <algorithm>
@@ -13,32 +24,184 @@ class EntityManager : public std::enable_shared_from_this<EntityManager>
 public:
     EntityManager() = default;
 
+    // The EntityManager is the only owner of the entities, everything else refers to them by
+    // handle (or by raw pointer for as long as it can't be removed, e.g. within a tick phase)
     void addShip(std::shared_ptr<Ship> ship);
-    void removeShip(std::shared_ptr<Ship> ship);
+    void removeShip(ShipHandle handle);
 
     void addStation(std::shared_ptr<Station> station);
-    void removeStation(std::shared_ptr<Station> station);
+    void removeStation(StationHandle handle);
 
     void addWarfStation(std::shared_ptr<WarfStation> warfStation);
     void removeWarfStation(std::shared_ptr<WarfStation> warfStation);
 
-    std::shared_ptr<Station> getStationById(int id);
+    // Stations get their handle when they're constructed (they need it while being set up),
+    // addStation then puts them into the slot
+    StationHandle allocateStationHandle()
+    {
+        return m_Stations.allocate();
+    }
+    // For stations that are destroyed without ever being added
+    void releaseStationHandle(StationHandle handle)
+    {
+        m_Stations.release(handle);
+    }
 
+    // Ids are handed out in order and never reused, they key the order book, the spatial grid and
+    // the random streams. Only called serially, so the ids come out the same on every run.
+    int generateId()
+    {
+        return m_NextId++;
+    }
+
+    // nullptr if the entity was removed in the meantime. Non-owning, don't hold on to the pointer
+    // past anything that could remove the entity.
+    Ship *getShip(ShipHandle handle) const
+    {
+        auto ship = m_Ships.get(handle);
+        return ship ? ship->get() : nullptr;
+    }
+    Station *getStation(StationHandle handle) const
+    {
+        auto station = m_Stations.get(handle);
+        return station ? station->get() : nullptr;
+    }
+    Station *getStationById(int id) const
+    {
+        auto it = m_StationHandlesById.find(id);
+        return it != m_StationHandlesById.end() ? getStation(it->second) : nullptr;
+    }
+
+    void setWorldSeed(uint64_t seed)
+    {
+        m_WorldSeed = seed;
+    }
+    uint64_t getWorldSeed() const
+    {
+        return m_WorldSeed;
+    }
+
+    // The simulation tick currently being processed, used to key random streams
+    void setTick(uint64_t tick)
+    {
+        m_Tick = tick;
+    }
+    uint64_t getTick() const
+    {
+        return m_Tick;
+    }
+
+    // Random stream for an entity in the current tick, see utils::RandomStream
+    utils::RandomStream getRandom(int entityId, utils::RandomPurpose purpose) const
+    {
+        return utils::RandomStream(m_WorldSeed, static_cast<uint64_t>(entityId), purpose, m_Tick);
+    }
+
+    // Removing an entity moves the last one into its place, so these are in no particular order
     const std::vector<std::shared_ptr<Ship>> &getShips() const
     {
-        return m_Ships;
+        return m_Ships.values();
     }
     const std::vector<std::shared_ptr<Station>> &getStations() const
     {
-        return m_Stations;
+        return m_Stations.values();
+    }
+    // Every station handle's index is below this
+    size_t getStationSlotCount() const
+    {
+        return m_Stations.slotCount();
     }
     const std::vector<std::shared_ptr<WarfStation>> &getWarfStations() const
     {
         return m_WarfStations;
     }
 
+    // Stations by position, kept in sync by addStation/removeStation
+    const SpatialGrid &getStationGrid() const
+    {
+        return m_StationGrid;
+    }
+
+    // Dense per-entity data behind the Ship and Station facades. Ships are registered by
+    // addShip/removeShip, stations register themselves for as long as they exist.
+    ShipComponents &getShipComponents()
+    {
+        return m_ShipComponents;
+    }
+    const ShipComponents &getShipComponents() const
+    {
+        return m_ShipComponents;
+    }
+    StationComponents &getStationComponents()
+    {
+        return m_StationComponents;
+    }
+    const StationComponents &getStationComponents() const
+    {
+        return m_StationComponents;
+    }
+
+    // Ships in flight, ships add themselves when they get a target
+    ShipKinematics &getShipKinematics()
+    {
+        return m_ShipKinematics;
+    }
+    const ShipKinematics &getShipKinematics() const
+    {
+        return m_ShipKinematics;
+    }
+
+    // Timers in simulated time, advanced once per tick by the Simulation
+    TimerWheel &getTimers()
+    {
+        return m_Timers;
+    }
+    const TimerWheel &getTimers() const
+    {
+        return m_Timers;
+    }
+
+    // Fights between ships, resolved once per tick by the Simulation
+    CombatSystem &getCombat()
+    {
+        return m_Combat;
+    }
+    const CombatSystem &getCombat() const
+    {
+        return m_Combat;
+    }
+
+    // Every station's open offers by ware and price, kept up to date by the stations themselves
+    OrderBook &getOrderBook()
+    {
+        return m_OrderBook;
+    }
+    const OrderBook &getOrderBook() const
+    {
+        return m_OrderBook;
+    }
+
 private:
-    std::vector<std::shared_ptr<Ship>> m_Ships;
-    std::vector<std::shared_ptr<Station>> m_Stations;
+    // stations give their slot back when they're destroyed, so this has to outlive them
+    StationComponents m_StationComponents;
+
+    SlotMap<Ship> m_Ships;
+    SlotMap<Station> m_Stations;
     std::vector<std::shared_ptr<WarfStation>> m_WarfStations;
+    // stations added so far, by id
+    std::unordered_map<int, StationHandle> m_StationHandlesById;
+    // 0 is left for ships that weren't added yet
+    int m_NextId = 1;
+
+    // destroyed before the ships, so it can hand their bodies back
+    ShipComponents m_ShipComponents;
+
+    SpatialGrid m_StationGrid = SpatialGrid(STATION_GRID_CELL_SIZE);
+    OrderBook m_OrderBook;
+    ShipKinematics m_ShipKinematics;
+    TimerWheel m_Timers;
+    CombatSystem m_Combat;
+
+    uint64_t m_WorldSeed = 0;
+    uint64_t m_Tick = 0;
 };
\ No newline at end of file
@@ -1,16 +1,16 @@
 #include "game.hpp"
-#include "productionStation.hpp"
-#include "productionModule.hpp"
+#include "station.hpp"
 #include "ship.hpp"
-#include "warfStation.hpp"
 #include "ui.hpp"
-#include "utils.hpp"
+#include "profiler.hpp"
+#include "metrics.hpp"
 
 #include "SDL2/SDL.h"
 #include "SDL2/SDL_image.h"
 #include "SDL2/SDL_ttf.h"
 
 #include <iostream>
+#include <random>
 #include <stdexcept>
 
 Game::Game()
@@ -90,39 +90,12 @@ void Game::initializeSDL()
 void Game::initializeEntities()
 {
     m_UI = std::make_shared<UI>(m_Renderer, m_Font);
-    m_EntityManager = std::make_shared<EntityManager>();
+    uint64_t worldSeed = (static_cast<uint64_t>(std::random_device{}()) << 32) | std::random_device{}();
+    printf("World seed: %llu\n", static_cast<unsigned long long>(worldSeed));
 
-    for (uint i = 0; i < 1000; i++)
-    {
-        float x = static_cast<float>(utils::gen() % 50000) - 25000.0f;
-        float y = static_cast<float>(utils::gen() % 50000) - 25000.0f;
-        auto station = ProductionStationPreset::createSiliconWaferProductionStation(vec2f(x, y), "Silicon Wafer Production " + std::to_string(i), m_EntityManager, m_UI, m_Renderer, m_Font);
-        m_EntityManager->addStation(station);
-    }
-
-    for (uint i = 0; i < 1000; i++)
-    {
-        float x = static_cast<float>(utils::gen() % 50000) - 25000.0f;
-        float y = static_cast<float>(utils::gen() % 50000) - 25000.0f;
-
-        auto ship = ShipPreset::createFreighter(vec2f(x, y), m_Renderer);
-        auto station = ProductionStationPreset::createSiliconProductionStation(vec2f(x, y), "Silicon Production " + std::to_string(i), m_EntityManager, m_UI, m_Renderer, m_Font);
-
-        station->addShip(ship);
-        m_EntityManager->addShip(ship);
-
-        m_EntityManager->addStation(station);
-    }
-
-    auto warfStation1 = std::make_shared<WarfStation>(vec2f(500, 400), "Warf Station 1", m_EntityManager, m_UI, m_Renderer, m_Font);
-    warfStation1->setMaintenanceLevel(Ware::SiliconWafers, 100000);
-
-    auto ship = ShipPreset::createFreighter(vec2f(500, 500), m_Renderer);
-    m_EntityManager->addShip(ship);
-
-    warfStation1->addShip(ship);
-
-    m_EntityManager->addWarfStation(warfStation1);
+    m_Simulation = std::make_shared<Simulation>(m_UI, m_Renderer, m_Font, worldSeed);
+    m_Simulation->initializeEntities();
+    m_EntityManager = m_Simulation->getEntityManager();
 }
 
 void Game::run()
@@ -138,75 +111,88 @@ void Game::run()
     Uint64 LAST = 0;
     double deltaTime = 0;
 
+    // simulated time that has not been stepped yet, always less than SIM_TIMESTEP after stepping
+    double simAccumulator = 0;
+
     Uint64 FPS_TIMER = SDL_GetPerformanceCounter();
     int frames = 0;
 
-    Uint64 lastTradeVolumeCheck = SDL_GetPerformanceCounter();
-
     while (!quit)
     {
-        while (SDL_PollEvent(&event))
+        PROFILE_ZONE("Frame");
+
         {
-            if (event.type == SDL_QUIT)
-            {
-                quit = true;
-            }
-            if (event.type == SDL_KEYDOWN)
+            PROFILE_ZONE("Event loop");
+
+            while (SDL_PollEvent(&event))
             {
-                switch (event.key.keysym.sym)
+                if (event.type == SDL_QUIT)
                 {
-                case SDLK_RIGHT:
-                    movingRight = true;
-                    break;
-                case SDLK_LEFT:
-                    movingLeft = true;
-                    break;
-                case SDLK_UP:
-                    movingUp = true;
-                    break;
-                case SDLK_DOWN:
-                    movingDown = true;
-                    break;
+                    quit = true;
                 }
-            }
-            if (event.type == SDL_KEYUP)
-            {
-                switch (event.key.keysym.sym)
+                if (event.type == SDL_KEYDOWN)
                 {
-                case SDLK_RIGHT:
-                    movingRight = false;
-                    break;
-                case SDLK_LEFT:
-                    movingLeft = false;
-                    break;
-                case SDLK_UP:
-                    movingUp = false;
-                    break;
-                case SDLK_DOWN:
-                    movingDown = false;
-                    break;
+                    switch (event.key.keysym.sym)
+                    {
+                    case SDLK_RIGHT:
+                        movingRight = true;
+                        break;
+                    case SDLK_LEFT:
+                        movingLeft = true;
+                        break;
+                    case SDLK_UP:
+                        movingUp = true;
+                        break;
+                    case SDLK_DOWN:
+                        movingDown = true;
+                        break;
+                    case SDLK_F9:
+                        toggleProfiling();
+                        break;
+                    case SDLK_F10:
+                        toggleMetricsOutput();
+                        break;
+                    }
                 }
-            }
-
-            if (event.type == SDL_MOUSEBUTTONUP)
-            {
-                for (auto &station : m_EntityManager->getStations())
+                if (event.type == SDL_KEYUP)
                 {
-                    station->deselect();
+                    switch (event.key.keysym.sym)
+                    {
+                    case SDLK_RIGHT:
+                        movingRight = false;
+                        break;
+                    case SDLK_LEFT:
+                        movingLeft = false;
+                        break;
+                    case SDLK_UP:
+                        movingUp = false;
+                        break;
+                    case SDLK_DOWN:
+                        movingDown = false;
+                        break;
+                    }
                 }
 
-                for (auto &station : m_EntityManager->getStations())
+                if (event.type == SDL_MOUSEBUTTONUP)
                 {
-                    station->checkForAndHandleMouseClick(camera, event.button.x, event.button.y);
+                    for (auto &station : m_EntityManager->getStations())
+                    {
+                        station->deselect();
+                    }
+
+                    for (auto &station : m_EntityManager->getStations())
+                    {
+                        station->checkForAndHandleMouseClick(camera, event.button.x, event.button.y);
+                    }
                 }
-            }
 
-            if (event.type == SDL_MOUSEWHEEL)
-            {
-                zoomLevel += event.wheel.y * 0.1f;
-                if (zoomLevel < 0.1f)
+                if (event.type == SDL_MOUSEWHEEL)
                 {
-                    zoomLevel = 0.1f;
+                    zoomLevel += event.wheel.y * 0.1f;
+                    if (zoomLevel < 0.1f)
+                    {
+                        zoomLevel = 0.1f;
+                    }
                 }
             }
         }
@@ -223,6 +209,7 @@ void Game::run()
         {
             float fps = frames / static_cast<float>(NOW - FPS_TIMER) * SDL_GetPerformanceFrequency();
             printf("FPS: %f\n", fps);
+            metrics::framesPerSecond.set(fps);
             FPS_TIMER = SDL_GetPerformanceCounter();
             frames = 0;
         }
@@ -251,29 +238,92 @@ void Game::run()
         SDL_GetRendererOutputSize(m_Renderer, &screenWidth, &screenHeight);
         vec2f zoomCenter = vec2f(screenWidth / 2, screenHeight / 2);
 
-        for (auto &station : m_EntityManager->getStations())
+        // step the simulation in fixed increments, a slow frame is spread over several steps
+        // (up to MAX_SIM_STEPS_PER_FRAME) and anything beyond that is dropped so we can catch up
+        simAccumulator += deltaTime;
+
+        int simSteps = 0;
+        while (simAccumulator >= SIM_TIMESTEP && simSteps < MAX_SIM_STEPS_PER_FRAME)
         {
-            station->reevaluateTradeOffers();
-            station->tick(deltaTime);
-            station->render(camera, zoomLevel, zoomCenter);
+            PROFILE_ZONE("Simulation::tick");
+            m_Simulation->tick(SIM_TIMESTEP);
+            simAccumulator -= SIM_TIMESTEP;
+            simSteps++;
         }
 
-        for (auto &ship : m_EntityManager->getShips())
+        if (simAccumulator >= SIM_TIMESTEP)
+        {
+            simAccumulator = 0;
+        }
+
+        // how far we are between the last two simulation states
+        float interpolation = static_cast<float>(simAccumulator / SIM_TIMESTEP);
+
         {
-            ship->searchForTrade(m_EntityManager->getStations(), deltaTime);
-            ship->tick(deltaTime);
-            ship->render(camera, zoomLevel, zoomCenter);
+            PROFILE_ZONE("Render stations");
+            for (auto &station : m_EntityManager->getStations())
+            {
+                station->render(camera, zoomLevel, zoomCenter);
+            }
         }
 
-        // every 5 seconds
-        if (NOW - lastTradeVolumeCheck > SDL_GetPerformanceFrequency() * 5)
         {
-            shipPurchaseCheck(m_EntityManager, lastTradeVolumeCheck);
+            PROFILE_ZONE("Render ships");
+            for (auto &ship : m_EntityManager->getShips())
+            {
+                ship->render(camera, zoomLevel, zoomCenter, interpolation);
+            }
         }
 
-        m_UI->render();
+        {
+            PROFILE_ZONE("UI::render");
+            m_UI->render();
+        }
 
-        SDL_RenderPresent(m_Renderer);
+        {
+            PROFILE_ZONE("SDL_RenderPresent");
+            SDL_RenderPresent(m_Renderer);
+        }
         // SDL_Delay(1000);
     }
-}
\ No newline at end of file
+}
+
+void Game::toggleProfiling()
+{
+    if (!profiler::isEnabled())
+    {
+        printf("Profiling started, press F9 again to write %s\n", PROFILER_TRACE_FILE);
+        profiler::setEnabled(true);
+        return;
+    }
+
+    profiler::setEnabled(false);
+
+    if (profiler::writeChromeTrace(PROFILER_TRACE_FILE))
+    {
+        printf("Profiling stopped, trace written to %s\n", PROFILER_TRACE_FILE);
+    }
+    else
+    {
+        printf("Profiling stopped, failed to write %s\n", PROFILER_TRACE_FILE);
+    }
+}
+
+void Game::toggleMetricsOutput()
+{
+    if (m_Simulation->isWritingMetrics())
+    {
+        m_Simulation->closeMetricsOutput();
+        printf("Stopped writing metrics to %s\n", METRICS_FILE);
+        return;
+    }
+
+    if (m_Simulation->openMetricsOutput(METRICS_FILE, METRICS_INTERVAL))
+    {
+        printf("Writing metrics to %s every %.0f seconds, press F10 again to stop\n", METRICS_FILE, METRICS_INTERVAL);
+    }
+    else
+    {
+        printf("Failed to open %s\n", METRICS_FILE);
+    }
+}
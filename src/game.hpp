@@ -1,6 +1,7 @@
 #pragma once
 
 #include "entityManager.hpp"
+#include "simulation.hpp"
 #include "ui.hpp"
 #include "vec.hpp"
 
@@ -11,6 +12,13 @@
 
 #define PLAYER_SPEED 500
 
+// Written (in the working directory) when profiling is stopped with F9
+#define PROFILER_TRACE_FILE "fourx_trace.json"
+
+// Metrics snapshots are appended to this file (in the working directory) while toggled on with F10
+#define METRICS_FILE "fourx_metrics.jsonl"
+#define METRICS_INTERVAL 5.0f
+
 class Game
 {
 public:
@@ -23,10 +31,14 @@ private:
     void initializeEntities();
     void initializeSDL();
 
+    void toggleProfiling();
+    void toggleMetricsOutput();
+
     SDL_Window *m_Window = nullptr;
     SDL_Renderer *m_Renderer = nullptr;
     TTF_Font *m_Font = nullptr;
 
+    std::shared_ptr<Simulation> m_Simulation = nullptr;
     std::shared_ptr<EntityManager> m_EntityManager = nullptr;
     std::shared_ptr<UI> m_UI = nullptr;
     vec2f m_Camera;
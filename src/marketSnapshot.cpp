@@ -0,0 +1,26 @@
+#include "marketSnapshot.hpp"
+#include "entityManager.hpp"
+#include "station.hpp"
+#include "threadPool.hpp"
+
+void MarketSnapshot::capture(const EntityManager &entityManager, ThreadPool &threadPool)
+{
+    auto &stations = entityManager.getStations();
+    m_StationsBySlot.resize(entityManager.getStationSlotCount());
+
+    threadPool.parallelFor(stations.size(), [&](size_t begin, size_t end, size_t)
+                           {
+        for (size_t i = begin; i < end; i++)
+        {
+            auto &station = stations[i];
+            auto &snapshot = m_StationsBySlot[station->getHandle().getIndex()];
+
+            snapshot.handle = station->getHandle();
+            snapshot.position = station->getPosition();
+            auto offers = station->getMarketOffers();
+            snapshot.buyOffers = offers.buyOffers;
+            snapshot.sellOffers = offers.sellOffers;
+            snapshot.openBuyOffers = offers.openBuyOffers;
+            snapshot.openSellOffers = offers.openSellOffers;
+        } });
+}
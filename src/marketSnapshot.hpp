@@ -0,0 +1,54 @@
+#pragma once
+
+#include "slotMap.hpp"
+#include "vec.hpp"
+#include "wares.hpp"
+
+#include <vector>
+
+class EntityManager;
+class ThreadPool;
+
+// Read-only copy of a single station's trade offers.
+struct StationMarketSnapshot
+{
+    StationHandle handle;
+    vec2f position;
+
+    wares::WareArray<wares::Offer> buyOffers;
+    wares::WareArray<wares::Offer> sellOffers;
+    uint32_t openBuyOffers;
+    uint32_t openSellOffers;
+
+    wares::MarketOffers getMarketOffers() const
+    {
+        return {buyOffers, sellOffers, openBuyOffers, openSellOffers};
+    }
+};
+
+// Copy of every station's buy/sell offers at one point in time. Ships can search it for trades
+// from many threads at once while the live stations keep changing; whatever they find has to be
+// validated against the live offers before it is accepted (see Ship::commitTrade).
+//
+// The copies are kept by slot index of the station handles, so capturing is a single parallel
+// pass and lookups are an index plus a generation check.
+class MarketSnapshot
+{
+public:
+    void capture(const EntityManager &entityManager, ThreadPool &threadPool);
+
+    // nullptr if the station was added after the snapshot was taken. A station removed since is
+    // still found, the handle has to come from the live world.
+    const StationMarketSnapshot *getStation(StationHandle handle) const
+    {
+        if (handle.getIndex() >= m_StationsBySlot.size())
+            return nullptr;
+
+        const StationMarketSnapshot &snapshot = m_StationsBySlot[handle.getIndex()];
+        return snapshot.handle == handle ? &snapshot : nullptr;
+    }
+
+private:
+    // slots without a station keep whatever was last captured there, the handle check skips them
+    std::vector<StationMarketSnapshot> m_StationsBySlot;
+};
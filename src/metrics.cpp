@@ -0,0 +1,95 @@
+#include "metrics.hpp"
+
+namespace metrics
+{
+    // function local, so metrics defined in other translation units can register during static initialization
+    static std::vector<Counter *> &counterRegistry()
+    {
+        static std::vector<Counter *> counters;
+        return counters;
+    }
+
+    static std::vector<Gauge *> &gaugeRegistry()
+    {
+        static std::vector<Gauge *> gauges;
+        return gauges;
+    }
+
+    Counter::Counter(const char *name) : m_Name(name)
+    {
+        counterRegistry().push_back(this);
+    }
+
+    int64_t Counter::get() const
+    {
+        int64_t value = 0;
+        for (auto &shard : m_Shards)
+        {
+            value += shard.value.load(std::memory_order_relaxed);
+        }
+        return value;
+    }
+
+    Gauge::Gauge(const char *name) : m_Name(name)
+    {
+        gaugeRegistry().push_back(this);
+    }
+
+    const std::vector<Counter *> &getCounters()
+    {
+        return counterRegistry();
+    }
+
+    const std::vector<Gauge *> &getGauges()
+    {
+        return gaugeRegistry();
+    }
+
+    void writeSnapshot(FILE *file, double simulatedTime)
+    {
+        fprintf(file, "{\"sim_time\": %.3f, \"counters\": {", simulatedTime);
+
+        bool first = true;
+        for (auto counter : getCounters())
+        {
+            fprintf(file, "%s\"%s\": %lld", first ? "" : ", ", counter->getName(), static_cast<long long>(counter->get()));
+            first = false;
+        }
+
+        fprintf(file, "}, \"gauges\": {");
+
+        first = true;
+        for (auto gauge : getGauges())
+        {
+            fprintf(file, "%s\"%s\": %g", first ? "" : ", ", gauge->getName(), gauge->get());
+            first = false;
+        }
+
+        fprintf(file, "}}\n");
+        fflush(file);
+    }
+
+    Counter tradesAccepted("trades_accepted");
+    Counter waresTransferred("wares_transferred");
+    Counter shipsDocked("ships_docked");
+    Counter shipsQueued("ships_queued");
+    Counter shipsAdmittedFromQueue("ships_admitted_from_queue");
+    Counter dockWaitTicks("dock_wait_ticks");
+    Counter productionCyclesCompleted("production_cycles_completed");
+    Counter productionCyclesHalted("production_cycles_halted");
+    Counter shipOrdersPlaced("ship_orders_placed");
+    Counter tradesAssigned("trades_assigned");
+    Counter combatHits("combat_hits");
+    Counter shipsDestroyed("ships_destroyed");
+
+    Gauge stations("stations");
+    Gauge ships("ships");
+    Gauge shipsInFlight("ships_in_flight");
+    Gauge dockedShips("docked_ships");
+    Gauge dockQueueDepth("dock_queue_depth");
+    Gauge maxDockQueueDepth("max_dock_queue_depth");
+    Gauge engagements("engagements");
+    Gauge scheduledTimers("scheduled_timers");
+
+    Gauge framesPerSecond("fps");
+}
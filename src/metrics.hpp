@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Counters and gauges for the economy and the game loop. Counters are sharded per thread, so
+// bumping one from a hot path (possibly on many threads at once) is a single uncontended relaxed
+// atomic add. All metrics register themselves, and writeSnapshot dumps every one of them.
+namespace metrics
+{
+    const size_t COUNTER_SHARDS = 16;
+
+    // Spreads threads over the counter shards
+    inline size_t shardIndex()
+    {
+        static std::atomic<size_t> nextShard = 0;
+        thread_local size_t shard = nextShard.fetch_add(1, std::memory_order_relaxed) % COUNTER_SHARDS;
+        return shard;
+    }
+
+    // Monotonically increasing count of events
+    class Counter
+    {
+    public:
+        explicit Counter(const char *name);
+
+        Counter(const Counter &) = delete;
+        Counter &operator=(const Counter &) = delete;
+
+        void add(int64_t value = 1)
+        {
+            m_Shards[shardIndex()].value.fetch_add(value, std::memory_order_relaxed);
+        }
+
+        int64_t get() const;
+
+        const char *getName() const
+        {
+            return m_Name;
+        }
+
+    private:
+        struct alignas(64) Shard
+        {
+            std::atomic<int64_t> value = 0;
+        };
+
+        const char *m_Name;
+        Shard m_Shards[COUNTER_SHARDS];
+    };
+
+    // Value that is set rather than counted, e.g. the number of ships
+    class Gauge
+    {
+    public:
+        explicit Gauge(const char *name);
+
+        Gauge(const Gauge &) = delete;
+        Gauge &operator=(const Gauge &) = delete;
+
+        void set(double value)
+        {
+            m_Value.store(value, std::memory_order_relaxed);
+        }
+
+        double get() const
+        {
+            return m_Value.load(std::memory_order_relaxed);
+        }
+
+        const char *getName() const
+        {
+            return m_Name;
+        }
+
+    private:
+        const char *m_Name;
+        std::atomic<double> m_Value = 0;
+    };
+
+    const std::vector<Counter *> &getCounters();
+    const std::vector<Gauge *> &getGauges();
+
+    // Writes the current value of every metric as a single JSON line
+    void writeSnapshot(FILE *file, double simulatedTime);
+
+    // economy
+    extern Counter tradesAccepted;
+    extern Counter waresTransferred;
+    extern Counter shipsDocked;
+    extern Counter shipsQueued;
+    extern Counter shipsAdmittedFromQueue;
+    extern Counter dockWaitTicks;
+    extern Counter productionCyclesCompleted;
+    extern Counter productionCyclesHalted;
+    extern Counter shipOrdersPlaced;
+    extern Counter tradesAssigned;
+    extern Counter combatHits;
+    extern Counter shipsDestroyed;
+
+    // world
+    extern Gauge stations;
+    extern Gauge ships;
+    extern Gauge shipsInFlight;
+    extern Gauge dockedShips;
+    extern Gauge dockQueueDepth;
+    extern Gauge maxDockQueueDepth;
+    extern Gauge engagements;
+    extern Gauge scheduledTimers;
+
+    // game loop
+    extern Gauge framesPerSecond;
+}
@@ -0,0 +1,133 @@
+#include "orderBook.hpp"
+
+void WareOrderBook::setOffer(wares::TradeType type, int stationId, Station *station, float price, int quantity)
+{
+    Side &side = getSide(type);
+    auto existing = side.byStation.find(stationId);
+
+    if (existing != side.byStation.end() && quantity > 0)
+    {
+        Entry &entry = existing->second;
+
+        // only reindex what changed (usually just the price), reusing the set nodes
+        if (entry.price != price)
+        {
+            auto node = side.byPrice.extract({entry.price, stationId});
+            node.value().first = price;
+            side.byPrice.insert(std::move(node));
+            entry.price = price;
+        }
+
+        if (entry.quantity != quantity)
+        {
+            auto node = side.byQuantity.extract({entry.quantity, -stationId});
+            node.value().first = quantity;
+            side.byQuantity.insert(std::move(node));
+            side.totalQuantity += quantity - entry.quantity;
+            entry.quantity = quantity;
+        }
+
+        return;
+    }
+
+    remove(side, stationId);
+
+    if (quantity <= 0)
+        return;
+
+    side.byPrice.insert({price, stationId});
+    side.byQuantity.insert({quantity, -stationId});
+    side.byStation[stationId] = {stationId, price, quantity, station};
+    side.totalQuantity += quantity;
+}
+
+void WareOrderBook::removeOffer(wares::TradeType type, int stationId)
+{
+    remove(getSide(type), stationId);
+}
+
+void WareOrderBook::remove(Side &side, int stationId)
+{
+    auto existing = side.byStation.find(stationId);
+    if (existing == side.byStation.end())
+        return;
+
+    side.byPrice.erase({existing->second.price, stationId});
+    side.byQuantity.erase({existing->second.quantity, -stationId});
+    side.totalQuantity -= existing->second.quantity;
+    side.byStation.erase(existing);
+}
+
+long long WareOrderBook::getTotalQuantity(wares::TradeType type) const
+{
+    return getSide(type).totalQuantity;
+}
+
+size_t WareOrderBook::getOfferCount(wares::TradeType type) const
+{
+    return getSide(type).byStation.size();
+}
+
+std::optional<WareOrderBook::Entry> WareOrderBook::getBestOffer(wares::TradeType type) const
+{
+    const Side &side = getSide(type);
+    if (side.byPrice.empty())
+        return std::nullopt;
+
+    int stationId = type == wares::TradeType::Sell ? side.byPrice.begin()->second : side.byPrice.rbegin()->second;
+    return side.byStation.at(stationId);
+}
+
+std::optional<WareOrderBook::Entry> WareOrderBook::getLargestOffer(wares::TradeType type) const
+{
+    const Side &side = getSide(type);
+    if (side.byQuantity.empty())
+        return std::nullopt;
+
+    return side.byStation.at(-side.byQuantity.rbegin()->second);
+}
+
+void WareOrderBook::getOffers(wares::TradeType type, std::vector<Entry> &result) const
+{
+    for (auto &offer : getSide(type).byStation)
+    {
+        result.push_back(offer.second);
+    }
+}
+
+std::vector<WareOrderBook::Entry> WareOrderBook::getSellersBelow(float maxPrice, size_t limit) const
+{
+    std::vector<Entry> result;
+    for (auto it = m_Sells.byPrice.begin(); it != m_Sells.byPrice.end() && result.size() < limit; it++)
+    {
+        if (it->first > maxPrice)
+            break;
+
+        result.push_back(m_Sells.byStation.at(it->second));
+    }
+
+    return result;
+}
+
+std::vector<WareOrderBook::Entry> WareOrderBook::getBuyersAbove(float minPrice, size_t limit) const
+{
+    std::vector<Entry> result;
+    for (auto it = m_Buys.byPrice.rbegin(); it != m_Buys.byPrice.rend() && result.size() < limit; it++)
+    {
+        if (it->first < minPrice)
+            break;
+
+        result.push_back(m_Buys.byStation.at(it->second));
+    }
+
+    return result;
+}
+
+void OrderBook::removeStation(int stationId)
+{
+    for (auto &book : m_Books)
+    {
+        book.removeOffer(wares::TradeType::Sell, stationId);
+        book.removeOffer(wares::TradeType::Buy, stationId);
+    }
+}
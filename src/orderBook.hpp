@@ -0,0 +1,94 @@
+#pragma once
+
+#include "wares.hpp"
+
+#include <array>
+#include <optional>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class Station;
+
+// Every station's open offers for one ware, ordered by price. Offers without quantity aren't
+// listed. The book isn't locked: stations only change their offers on the main thread, the
+// parallel readers (TradeAssigner) run while nothing writes.
+class WareOrderBook
+{
+public:
+    struct Entry
+    {
+        int stationId;
+        float price;
+        int quantity;
+        // non-owning, the EntityManager owns the station
+        Station *station;
+    };
+
+    // Sets a station's offer, a quantity of 0 removes it
+    void setOffer(wares::TradeType type, int stationId, Station *station, float price, int quantity);
+    void removeOffer(wares::TradeType type, int stationId);
+
+    // Total quantity of all open offers on one side of the book
+    long long getTotalQuantity(wares::TradeType type) const;
+    size_t getOfferCount(wares::TradeType type) const;
+    // Lowest priced sell offer or highest priced buy offer
+    std::optional<Entry> getBestOffer(wares::TradeType type) const;
+    // Offer with the largest quantity on one side of the book, lowest station id on ties
+    std::optional<Entry> getLargestOffer(wares::TradeType type) const;
+
+    // Appends every open offer on one side of the book to result, in no particular order
+    void getOffers(wares::TradeType type, std::vector<Entry> &result) const;
+
+    // Sell offers at or below maxPrice, cheapest first, at most limit entries
+    std::vector<Entry> getSellersBelow(float maxPrice, size_t limit) const;
+    // Buy offers at or above minPrice, highest paying first, at most limit entries
+    std::vector<Entry> getBuyersAbove(float minPrice, size_t limit) const;
+
+private:
+    struct Side
+    {
+        // (price, station id), the id keeps equal prices in a stable order
+        std::set<std::pair<float, int>> byPrice;
+        // (quantity, -station id), largest quantity last
+        std::set<std::pair<int, int>> byQuantity;
+        std::unordered_map<int, Entry> byStation;
+        long long totalQuantity = 0;
+    };
+
+    Side &getSide(wares::TradeType type)
+    {
+        return type == wares::TradeType::Sell ? m_Sells : m_Buys;
+    }
+    const Side &getSide(wares::TradeType type) const
+    {
+        return type == wares::TradeType::Sell ? m_Sells : m_Buys;
+    }
+
+    void remove(Side &side, int stationId);
+
+    Side m_Sells;
+    Side m_Buys;
+};
+
+// Global order book with one WareOrderBook per ware. Stations keep it up to date whenever they
+// change an offer (see Station::updateTradeOffer), so questions about the whole market don't
+// have to walk every station.
+class OrderBook
+{
+public:
+    WareOrderBook &operator[](wares::Ware ware)
+    {
+        return m_Books[static_cast<size_t>(ware)];
+    }
+    const WareOrderBook &operator[](wares::Ware ware) const
+    {
+        return m_Books[static_cast<size_t>(ware)];
+    }
+
+    void removeStation(int stationId);
+
+private:
+    std::array<WareOrderBook, wares::WARE_COUNT> m_Books;
+};
@@ -1,23 +1,26 @@
 #pragma once
 
+#include <cstdint>
+#include <stdexcept>
 #include <variant>
-#include <memory>
 
+#include "slotMap.hpp"
+#include "vec.hpp"
 #include "wares.hpp"
 
-class Station;
+// Orders refer to stations by handle, a station that's gone by the time the order runs simply doesn't resolve
 
 namespace orders
 {
 
     struct DockAtStation
     {
-        std::shared_ptr<Station> station;
+        StationHandle station;
     };
 
     struct TradeWithStation
     {
-        std::shared_ptr<Station> station;
+        StationHandle station;
         wares::TradeType type;
         wares::Ware ware;
         int quantity;
@@ -32,7 +35,93 @@ namespace orders
         vec2f position;
     };
 
+    // A whole trade compiled into one order: undock, dock at the seller, buy, undock, dock at the
+    // buyer, sell. It stays at the front of the ship's queue while its steps run one by one.
+    struct TradeItinerary
+    {
+        enum class Step : uint8_t
+        {
+            Undock,
+            DockAtSeller,
+            Buy,
+            UndockFromSeller,
+            DockAtBuyer,
+            Sell,
+            Done,
+        };
+
+        StationHandle seller;
+        StationHandle buyer;
+        int quantity;
+        wares::Ware ware;
+        Step step = Step::Undock;
+
+        // Moves on to the next step, false once the last one ran
+        bool advance()
+        {
+            step = static_cast<Step>(static_cast<uint8_t>(step) + 1);
+            return step != Step::Done;
+        }
+    };
+
 }
 
-typedef std::variant<orders::DockAtStation, orders::TradeWithStation, orders::Undock, orders::MoveToPosition>
-    ShipOrder;
\ No newline at end of file
+typedef std::variant<orders::DockAtStation, orders::TradeWithStation, orders::Undock, orders::MoveToPosition, orders::TradeItinerary>
+    ShipOrder;
+
+// A ship's orders, in a ring buffer stored inline in the ship. Issuing and running orders never
+// allocates and only touches this one cache line. A trade is a single TradeItinerary and ships
+// only look for the next one once their queue is empty, so two slots are plenty. Pushing onto a
+// full queue throws, see Ship::addOrder for who may push.
+class alignas(64) OrderQueue
+{
+public:
+    static const uint8_t CAPACITY = 2;
+
+    bool empty() const
+    {
+        return m_Count == 0;
+    }
+
+    size_t size() const
+    {
+        return m_Count;
+    }
+
+    ShipOrder &front()
+    {
+        return m_Orders[m_Head];
+    }
+
+    void push(const ShipOrder &order)
+    {
+        if (m_Count == CAPACITY)
+            throw std::runtime_error("Ship order queue is full");
+
+        uint8_t tail = m_Head + m_Count;
+        if (tail >= CAPACITY)
+            tail -= CAPACITY;
+
+        m_Orders[tail] = order;
+        m_Count++;
+    }
+
+    void pop()
+    {
+        m_Head = m_Head + 1 == CAPACITY ? 0 : m_Head + 1;
+        m_Count--;
+    }
+
+    void clear()
+    {
+        m_Head = 0;
+        m_Count = 0;
+    }
+
+private:
+    ShipOrder m_Orders[CAPACITY];
+    uint8_t m_Head = 0;
+    uint8_t m_Count = 0;
+};
+
+static_assert(sizeof(OrderQueue) == 64, "OrderQueue should fit in a single cache line");
\ No newline at end of file
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Fixed-size blocks carved out of large slabs, with freed blocks kept on a free list for the next
+// allocation. After warming up, allocating and freeing is a couple of pointer moves and never
+// touches the general heap, and objects of one type end up next to each other in memory.
+//
+// There is one pool per block size and alignment, shared by everything allocated through
+// PoolAllocator. Pools aren't thread safe: entities are only created and destroyed on the main
+// thread (ships finished by station timers are added through the CommandBuffer).
+template <size_t BlockSize, size_t Alignment>
+class SlabPool
+{
+public:
+    static const size_t BLOCKS_PER_SLAB = 256;
+
+    static SlabPool &instance()
+    {
+        static SlabPool pool;
+        return pool;
+    }
+
+    void *allocate()
+    {
+        if (m_FreeList == nullptr)
+        {
+            addSlab();
+        }
+
+        FreeBlock *block = m_FreeList;
+        m_FreeList = block->next;
+        m_Allocated++;
+        return block;
+    }
+
+    void deallocate(void *pointer)
+    {
+        // freed blocks go to the front, so the next allocation reuses memory that's still warm
+        FreeBlock *block = static_cast<FreeBlock *>(pointer);
+        block->next = m_FreeList;
+        m_FreeList = block;
+        m_Allocated--;
+    }
+
+    size_t getAllocatedCount() const
+    {
+        return m_Allocated;
+    }
+    size_t getCapacity() const
+    {
+        return m_Slabs.size() * BLOCKS_PER_SLAB;
+    }
+
+    SlabPool(const SlabPool &) = delete;
+    SlabPool &operator=(const SlabPool &) = delete;
+
+    ~SlabPool()
+    {
+        // anything still allocated at exit keeps its slab
+        if (m_Allocated != 0)
+            return;
+
+        for (void *slab : m_Slabs)
+        {
+            ::operator delete(slab, std::align_val_t(ALIGNMENT));
+        }
+    }
+
+private:
+    struct FreeBlock
+    {
+        FreeBlock *next;
+    };
+
+    // a free block has to be able to hold the free list link
+    static const size_t BLOCK_SIZE = BlockSize < sizeof(FreeBlock) ? sizeof(FreeBlock) : BlockSize;
+    static const size_t ALIGNMENT = Alignment < alignof(FreeBlock) ? alignof(FreeBlock) : Alignment;
+    static const size_t STRIDE = (BLOCK_SIZE + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+    SlabPool() = default;
+
+    void addSlab()
+    {
+        char *slab = static_cast<char *>(::operator new(STRIDE * BLOCKS_PER_SLAB, std::align_val_t(ALIGNMENT)));
+        m_Slabs.push_back(slab);
+
+        // link the blocks back to front, so they're handed out in address order
+        for (size_t i = BLOCKS_PER_SLAB; i > 0; i--)
+        {
+            FreeBlock *block = reinterpret_cast<FreeBlock *>(slab + (i - 1) * STRIDE);
+            block->next = m_FreeList;
+            m_FreeList = block;
+        }
+    }
+
+    std::vector<void *> m_Slabs;
+    FreeBlock *m_FreeList = nullptr;
+    size_t m_Allocated = 0;
+};
+
+// Standard allocator on top of the SlabPool for T's size. Meant for std::allocate_shared, which
+// rebinds it to its control block type, so the object and its reference counts share one block.
+template <typename T>
+class PoolAllocator
+{
+public:
+    typedef T value_type;
+
+    PoolAllocator() = default;
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U> &) {}
+
+    T *allocate(size_t count)
+    {
+        if (count != 1)
+            return static_cast<T *>(::operator new(count * sizeof(T), std::align_val_t(alignof(T))));
+
+        return static_cast<T *>(SlabPool<sizeof(T), alignof(T)>::instance().allocate());
+    }
+
+    void deallocate(T *pointer, size_t count)
+    {
+        if (count != 1)
+        {
+            ::operator delete(pointer, std::align_val_t(alignof(T)));
+            return;
+        }
+
+        SlabPool<sizeof(T), alignof(T)>::instance().deallocate(pointer);
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U> &) const
+    {
+        return true;
+    }
+    template <typename U>
+    bool operator!=(const PoolAllocator<U> &) const
+    {
+        return false;
+    }
+};
+
+// std::make_shared, but from the pool
+template <typename T, typename... Args>
+std::shared_ptr<T> makePooled(Args &&...args)
+{
+    return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+}
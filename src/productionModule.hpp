@@ -14,7 +14,6 @@ struct ProductionModule
     bool halted = true;
 
     int cycle_time;
-    float current_cycle_time = 0;
 };
 
 namespace ProductionModulePreset
@@ -24,7 +23,6 @@ namespace ProductionModulePreset
         ProductionModule siliconProduction;
         siliconProduction.outputWares.push_back(wares::WareQuantity{wares::Ware::Silicon, 150});
         siliconProduction.cycle_time = 5;
-        // siliconProduction.current_cycle_time = utils::gen() % siliconProduction.cycle_time;
         return siliconProduction;
     }
 
@@ -34,7 +32,6 @@ namespace ProductionModulePreset
         siliconWaferProduction.inputWares.push_back({wares::Ware::Silicon, 100});
         siliconWaferProduction.outputWares.push_back(wares::WareQuantity{wares::Ware::SiliconWafers, 50});
         siliconWaferProduction.cycle_time = 5;
-        // siliconWaferProduction.current_cycle_time = utils::gen() % siliconWaferProduction.cycle_time;
         return siliconWaferProduction;
     }
 }
\ No newline at end of file
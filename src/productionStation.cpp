@@ -1,26 +1,30 @@
 #include "productionStation.hpp"
+#include "metrics.hpp"
 
 void ProductionStation::addProductionModule(ProductionModule module)
 {
+    StationMarket &market = this->market();
 
     this->productionModules.push_back(module);
-    this->startNewProductionCycle(productionModules.back());
+    this->startNewProductionCycle(productionModules.size() - 1);
 
     for (auto &inputWare : module.inputWares)
     {
-        if (this->inventory.find(inputWare.ware) == this->inventory.end())
+        if (market.inventory.find(inputWare.ware) == market.inventory.end())
         {
-            this->inventory[inputWare.ware] = 0;
+            market.inventory[inputWare.ware] = 0;
         }
     }
 }
 
-void ProductionStation::startNewProductionCycle(ProductionModule &productionModule)
+void ProductionStation::startNewProductionCycle(size_t moduleIndex)
 {
+    auto &productionModule = this->productionModules[moduleIndex];
+
     productionModule.halted = false;
     for (auto &inputWare : productionModule.inputWares)
     {
-        if (inventory[inputWare.ware] < inputWare.quantity)
+        if (market().inventory[inputWare.ware] < inputWare.quantity)
         {
             productionModule.halted = true;
             break;
@@ -29,8 +33,7 @@ void ProductionStation::startNewProductionCycle(ProductionModule &productionModu
 
     if (productionModule.halted)
     {
-        // not enough input wares
-        productionModule.current_cycle_time = 0;
+        // not enough input wares, postUpdateInventory tries again once some arrive
         return;
     }
 
@@ -38,52 +41,50 @@ void ProductionStation::startNewProductionCycle(ProductionModule &productionModu
     {
         this->updateInventory(inputWare.ware, -inputWare.quantity);
     }
+
+    this->scheduleTimer(productionModule.cycle_time, static_cast<uint32_t>(moduleIndex));
 }
 
-void ProductionStation::tick(float dt)
+void ProductionStation::onTimer(uint32_t id, CommandBuffer &commands)
 {
+    auto &productionModule = this->productionModules[id];
 
-    for (auto &productionModule : this->productionModules)
+    for (auto &outputWare : productionModule.outputWares)
     {
-        if (productionModule.halted)
-            continue;
-
-        productionModule.current_cycle_time += dt;
-
-        if (productionModule.current_cycle_time < productionModule.cycle_time)
+        if (std::holds_alternative<wares::WareQuantity>(outputWare))
+        {
+            auto wareQuantity = std::get<wares::WareQuantity>(outputWare);
+            this->updateInventory(wareQuantity.ware, wareQuantity.quantity);
             continue;
-
-        for (auto &outputWare : productionModule.outputWares)
+        }
+        else if (std::holds_alternative<wares::ShipOrder>(outputWare))
         {
-            if (std::holds_alternative<wares::WareQuantity>(outputWare))
-            {
-                auto wareQuantity = std::get<wares::WareQuantity>(outputWare);
-                this->updateInventory(wareQuantity.ware, wareQuantity.quantity);
-                continue;
-            }
-            else if (std::holds_alternative<wares::ShipOrder>(outputWare))
-            {
-                auto shipOrder = std::get<wares::ShipOrder>(outputWare);
-                auto ship = std::make_shared<Ship>(this->m_Position, shipOrder.maxSpeed, shipOrder.cargoCapacity, shipOrder.weaponAttack, m_Renderer);
+            // the ship goes to the station that ordered it
+            auto shipOrder = std::get<wares::ShipOrder>(outputWare);
+            commands.spawnShip({this->getPosition(), shipOrder.maxSpeed, shipOrder.cargoCapacity, shipOrder.weaponAttack, shipOrder.station, m_Renderer});
 
-                continue;
-            }
+            continue;
         }
+    }
 
-        productionModule.current_cycle_time -= productionModule.cycle_time;
+    metrics::productionCyclesCompleted.add();
 
-        // start new cycle
-        startNewProductionCycle(productionModule);
+    // start new cycle
+    startNewProductionCycle(id);
+
+    if (productionModule.halted)
+    {
+        metrics::productionCyclesHalted.add();
     }
 }
 
 void ProductionStation::postUpdateInventory()
 {
-    for (auto &productionModule : this->productionModules)
+    for (size_t i = 0; i < this->productionModules.size(); i++)
     {
-        if (productionModule.halted)
+        if (this->productionModules[i].halted)
         {
-            startNewProductionCycle(productionModule);
+            startNewProductionCycle(i);
         }
     }
 }
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "profiler.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace profiler
+{
+    std::atomic<bool> g_Enabled = false;
+
+    // zones recorded per thread, so recording doesn't need a lock
+    struct ZoneEvent
+    {
+        const char *name;
+        uint64_t start;
+        uint64_t end;
+    };
+
+    struct ThreadBuffer
+    {
+        int threadId;
+        std::vector<ZoneEvent> events;
+    };
+
+    // upper bound per thread, so a forgotten recording can't eat all memory
+    static const size_t MAX_EVENTS_PER_THREAD = 1 << 22;
+
+    static std::mutex s_BuffersMutex;
+    static std::vector<std::unique_ptr<ThreadBuffer>> s_Buffers;
+    static const auto s_Epoch = std::chrono::steady_clock::now();
+
+    static ThreadBuffer &getThreadBuffer()
+    {
+        thread_local ThreadBuffer *buffer = nullptr;
+
+        if (buffer == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(s_BuffersMutex);
+            s_Buffers.push_back(std::make_unique<ThreadBuffer>());
+            buffer = s_Buffers.back().get();
+            buffer->threadId = static_cast<int>(s_Buffers.size());
+        }
+
+        return *buffer;
+    }
+
+    void setEnabled(bool enabled)
+    {
+        if (enabled)
+        {
+            std::lock_guard<std::mutex> lock(s_BuffersMutex);
+            for (auto &buffer : s_Buffers)
+            {
+                buffer->events.clear();
+            }
+        }
+
+        g_Enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    uint64_t now()
+    {
+        // +1 so a valid timestamp is never 0, Zone uses 0 for "not recording"
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_Epoch).count() + 1;
+    }
+
+    void recordZone(const char *name, uint64_t start, uint64_t end)
+    {
+        ThreadBuffer &buffer = getThreadBuffer();
+
+        if (buffer.events.size() >= MAX_EVENTS_PER_THREAD)
+            return;
+
+        buffer.events.push_back({name, start, end});
+    }
+
+    bool writeChromeTrace(const std::string &path)
+    {
+        FILE *file = fopen(path.c_str(), "w");
+        if (!file)
+        {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(s_BuffersMutex);
+
+        fprintf(file, "{\"traceEvents\":[\n");
+
+        bool first = true;
+        for (auto &buffer : s_Buffers)
+        {
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+                    first ? "" : ",\n", buffer->threadId, buffer->threadId);
+            first = false;
+
+            for (auto &event : buffer->events)
+            {
+                fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                        event.name, buffer->threadId, event.start / 1000.0, (event.end - event.start) / 1000.0);
+            }
+        }
+
+        fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+        return fclose(file) == 0;
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Lightweight instrumentation. Wrap a scope in PROFILE_ZONE("name") to record how long it took.
+// Zones are only recorded while profiling is enabled at runtime (a single relaxed load otherwise),
+// and compile to nothing when FOURX_PROFILING isn't defined. The recorded zones can be written as
+// a Chrome/Perfetto trace (chrome://tracing or ui.perfetto.dev).
+namespace profiler
+{
+    extern std::atomic<bool> g_Enabled;
+
+    // Starts a new recording (dropping whatever was recorded before) or stops the current one.
+    void setEnabled(bool enabled);
+
+    inline bool isEnabled()
+    {
+        return g_Enabled.load(std::memory_order_relaxed);
+    }
+
+    // Writes everything recorded so far as Chrome trace event JSON. Must not be called while
+    // other threads are inside a zone, i.e. call it between ticks. Returns false if the file
+    // couldn't be written.
+    bool writeChromeTrace(const std::string &path);
+
+    uint64_t now();
+    void recordZone(const char *name, uint64_t start, uint64_t end);
+
+    class Zone
+    {
+    public:
+        explicit Zone(const char *name) : m_Name(name), m_Start(isEnabled() ? now() : 0) {}
+
+        ~Zone()
+        {
+            if (m_Start != 0 && isEnabled())
+            {
+                recordZone(m_Name, m_Start, now());
+            }
+        }
+
+        Zone(const Zone &) = delete;
+        Zone &operator=(const Zone &) = delete;
+
+    private:
+        const char *m_Name;
+        uint64_t m_Start;
+    };
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef FOURX_PROFILING
+// name has to be a string literal (or otherwise outlive the recording)
+#define PROFILE_ZONE(name) profiler::Zone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name)
+#endif
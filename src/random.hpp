@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+namespace utils
+{
+    // What a random draw is used for. Each purpose gets its own stream, so e.g. the trade check
+    // backoff and the trade choice of a ship in the same tick don't share numbers.
+    enum class RandomPurpose : uint32_t
+    {
+        WorldGeneration,
+        TradeCheck,
+        TradeChoice,
+        Combat,
+    };
+
+    // Squares counter-based RNG (B. Widynski, 2020), four rounds, 32 bits out.
+    inline uint32_t squares32(uint64_t counter, uint64_t key)
+    {
+        uint64_t x, y, z;
+        y = x = counter * key;
+        z = y + key;
+        x = x * x + y;
+        x = (x >> 32) | (x << 32);
+        x = x * x + z;
+        x = (x >> 32) | (x << 32);
+        x = x * x + y;
+        x = (x >> 32) | (x << 32);
+        return static_cast<uint32_t>((x * x + z) >> 32);
+    }
+
+    inline uint64_t splitmix64(uint64_t x)
+    {
+        x += 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+    // Stateless random stream for one entity in one tick. The numbers only depend on the world
+    // seed, entity id, purpose, tick and how many numbers were drawn before, so any thread can
+    // draw without contention and results don't depend on the order entities are updated in.
+    // Satisfies UniformRandomBitGenerator, so it can be used with <random> distributions.
+    class RandomStream
+    {
+    public:
+        typedef uint32_t result_type;
+
+        RandomStream(uint64_t worldSeed, uint64_t entityId, RandomPurpose purpose, uint64_t tick)
+            : m_Key(makeKey(worldSeed, entityId, purpose)), m_Counter(tick << 32)
+        {
+        }
+
+        result_type operator()()
+        {
+            return squares32(m_Counter++, m_Key);
+        }
+
+        static constexpr result_type min()
+        {
+            return 0;
+        }
+
+        static constexpr result_type max()
+        {
+            return std::numeric_limits<result_type>::max();
+        }
+
+    private:
+        static uint64_t makeKey(uint64_t worldSeed, uint64_t entityId, RandomPurpose purpose)
+        {
+            uint64_t key = splitmix64(worldSeed);
+            key = splitmix64(key ^ entityId);
+            key = splitmix64(key ^ static_cast<uint64_t>(purpose));
+            // squares wants a key with irregular bits and an odd low bit
+            return key | 1;
+        }
+
+        uint64_t m_Key;
+        uint64_t m_Counter;
+    };
+}
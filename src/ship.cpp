@@ -5,268 +5,361 @@
 #include "wares.hpp"
 #include "orders.hpp"
 #include "entityManager.hpp"
+#include "marketSnapshot.hpp"
 
 #include <algorithm>
 #include <iostream>
-#include <random>
 #include <cassert>
 
-Ship::Ship(vec2f m_Position, float maxSpeed, float cargoCapacity, float weaponAttack, SDL_Renderer *renderer) : m_Position(m_Position), maxSpeed(maxSpeed), cargoCapacity(cargoCapacity), weaponAttack(weaponAttack), m_Renderer(renderer)
+Ship::Ship(vec2f position, float maxSpeed, float cargoCapacity, float weaponAttack, SDL_Renderer *renderer) : maxSpeed(maxSpeed), cargoCapacity(cargoCapacity), weaponAttack(weaponAttack), m_Renderer(renderer)
 {
-    this->id = utils::generateId();
+    this->m_Body.position = position;
+    this->m_Body.previousPosition = position;
 }
 
-void Ship::claim(std::shared_ptr<Station> station)
+void Ship::claim(StationHandle station)
 {
     this->owner = station;
+    this->scheduleTradeCheck();
 }
 
-void Ship::dock(std::shared_ptr<Station> station)
+void Ship::dock(Station &station, uint32_t slot)
 {
-    this->dockedStation = station;
+    this->dockedStation = station.getHandle();
+    this->m_DockSlot = slot;
     this->executeNextOrder();
 }
 
-void Ship::searchForTrade(const std::vector<std::shared_ptr<Station>> &stations, float dt)
+// Wares the ship could trade between its owner and a station, one bit per ware. The types are from
+// the ship's point of view: sell means it buys from the station and sells to the owner, buy means
+// it buys from the owner and sells to the station.
+struct TradeMatches
 {
-    if (this->m_Orders.size() > 0)
+    uint32_t sell;
+    uint32_t buy;
+
+    bool any() const
     {
-        return;
+        return (sell | buy) != 0;
+    }
+
+    bool contains(wares::TradeType type, wares::Ware ware) const
+    {
+        return ((type == wares::TradeType::Sell ? sell : buy) & (1u << static_cast<uint32_t>(ware))) != 0;
+    }
+};
+
+static TradeMatches matchOffers(const wares::MarketOffers &owner, const wares::MarketOffers &station)
+{
+    TradeMatches matches{owner.openBuyOffers & station.openSellOffers, owner.openSellOffers & station.openBuyOffers};
+
+    // only the wares both sides have open offers for are left, check their prices
+    for (uint32_t candidates = matches.sell; candidates != 0; candidates &= candidates - 1)
+    {
+        auto ware = static_cast<wares::Ware>(wares::lowestBitIndex(candidates));
+        if (station.sellOffers.get(ware).price > owner.buyOffers.get(ware).price)
+            matches.sell &= ~(1u << static_cast<uint32_t>(ware));
+    }
+
+    for (uint32_t candidates = matches.buy; candidates != 0; candidates &= candidates - 1)
+    {
+        auto ware = static_cast<wares::Ware>(wares::lowestBitIndex(candidates));
+        if (station.buyOffers.get(ware).price < owner.sellOffers.get(ware).price)
+            matches.buy &= ~(1u << static_cast<uint32_t>(ware));
+    }
+
+    return matches;
+}
+
+static std::vector<std::pair<wares::TradeType, wares::Ware>> toTradeList(TradeMatches matches)
+{
+    std::vector<std::pair<wares::TradeType, wares::Ware>> trades;
+
+    for (uint32_t remaining = matches.sell; remaining != 0; remaining &= remaining - 1)
+    {
+        trades.push_back({wares::TradeType::Sell, static_cast<wares::Ware>(wares::lowestBitIndex(remaining))});
     }
 
-    if (this->owner == nullptr)
+    for (uint32_t remaining = matches.buy; remaining != 0; remaining &= remaining - 1)
+    {
+        trades.push_back({wares::TradeType::Buy, static_cast<wares::Ware>(wares::lowestBitIndex(remaining))});
+    }
+
+    return trades;
+}
+
+bool Ship::readyForTradeSearch()
+{
+    this->m_TradeCheckScheduled = false;
+
+    // got orders in the meantime, the check is scheduled again once they're done
+    if (!this->m_Orders.empty())
+    {
+        return false;
+    }
+
+    // no owner, or the owner is gone. A gone owner isn't coming back, the ship stops checking
+    if (this->m_Manager->getStation(this->owner) == nullptr)
+    {
+        this->owner = StationHandle();
+        return false;
+    }
+
+    auto random = this->m_Manager->getRandom(this->id, utils::RandomPurpose::TradeCheck);
+    this->m_TradeCheckDelay = static_cast<float>(random() % 60);
+    return true;
+}
+
+void Ship::scheduleTradeCheck()
+{
+    // not in the EntityManager yet, not owned, already waiting for a check or busy
+    if (this->m_Manager == nullptr || this->m_Handle.isNull() || this->owner.isNull() || this->m_TradeCheckScheduled || !this->m_Orders.empty())
     {
         return;
     }
 
-    if (this->m_TimeUntilNextTradeCheck > 0)
+    this->m_Manager->getTimers().schedule(this->m_TradeCheckDelay, timers::TradeCheck{this->m_Handle});
+    this->m_TradeCheckScheduled = true;
+    this->m_TradeCheckDelay = 0;
+}
+
+void Ship::searchForTrade()
+{
+    if (!this->readyForTradeSearch())
     {
-        this->m_TimeUntilNextTradeCheck -= dt;
         return;
     }
 
-    this->m_TimeUntilNextTradeCheck = static_cast<float>(utils::gen() % 60);
+    Station *ownerStation = this->m_Manager->getStation(this->owner);
+    int ownerId = ownerStation->getId();
+    auto ownerOffers = ownerStation->getMarketOffers();
 
-    std::vector<size_t> station_indices;
-    station_indices.reserve(stations.size());
+    // nearest stations first, most searches stop after a handful of them
+    auto nearestStations = this->m_Manager->getStationGrid().nearest(this->body().position);
 
-    // populate station_indices
-    for (size_t i = 0; i < stations.size(); i++)
+    while (const SpatialGrid::Entry *entry = nearestStations.next())
     {
-        if (stations[i]->getId() == this->owner->getId())
-        {
+        if (entry->id == ownerId)
             continue;
-        }
 
-        // float distance = vec2f::distance(this->m_Position, stations[i]->getPosition());
-        auto &targetStationPosition = stations[i]->getPosition();
-        float deltaX = targetStationPosition.x - this->m_Position.x;
-        float deltaY = targetStationPosition.y - this->m_Position.y;
+        Station *station = entry->station;
 
-        float distance = deltaX * deltaX + deltaY * deltaY;
+        TradeMatches matches = matchOffers(ownerOffers, station->getMarketOffers());
 
-        static const float maxDistance = 1000 * 1000; // squared distance
-        // if (distance > maxDistance)
-        // {
-        //     continue;
-        // }
+        if (!matches.any())
+            continue;
 
-        station_indices.push_back(i);
+        this->commitTrade(TradeProposal{station->getHandle(), toTradeList(matches)});
+        break;
     }
 
-    // std::shuffle(station_indices.begin(), station_indices.end(), utils::gen);
-    std::sort(station_indices.begin(), station_indices.end(), [&](size_t a, size_t b)
-              {
-        auto &targetStationPositionA = stations[a]->getPosition();
-        auto &targetStationPositionB = stations[b]->getPosition();
+    // only schedules if no trade was found, otherwise once the trade is done
+    this->scheduleTradeCheck();
+}
 
-        float deltaXA = targetStationPositionA.x - this->m_Position.x;
-        float deltaYA = targetStationPositionA.y - this->m_Position.y;
-        float distanceA = deltaXA * deltaXA + deltaYA * deltaYA;
+std::optional<TradeProposal> Ship::findTrade(const MarketSnapshot &snapshot) const
+{
+    // only reads the slot map, which doesn't change while the searches run
+    const Station *ownerStation = this->m_Manager->getStation(this->owner);
+    const StationMarketSnapshot *ownerSnapshot = ownerStation ? snapshot.getStation(this->owner) : nullptr;
 
-        float deltaXB = targetStationPositionB.x - this->m_Position.x;
-        float deltaYB = targetStationPositionB.y - this->m_Position.y;
-        float distanceB = deltaXB * deltaXB + deltaYB * deltaYB;
+    if (ownerSnapshot == nullptr)
+    {
+        return std::nullopt;
+    }
 
-        return distanceA < distanceB; });
+    auto ownerOffers = ownerSnapshot->getMarketOffers();
 
-    auto buyOffersOwner = this->owner->getBuyOffers();
-    auto sellOffersOwner = this->owner->getSellOffers();
+    // stations don't move, so the live grid can be used to walk the snapshot nearest first
+    auto nearestStations = this->m_Manager->getStationGrid().nearest(this->body().position);
 
-    for (size_t index : station_indices)
+    while (const SpatialGrid::Entry *entry = nearestStations.next())
     {
-        auto station = stations[index];
+        if (entry->station == ownerStation)
+            continue;
 
-        auto buyOffersStation = station->getBuyOffers();
-        auto sellOffersStation = station->getSellOffers();
+        const StationMarketSnapshot *station = snapshot.getStation(entry->station->getHandle());
 
-        std::vector<std::pair<wares::TradeType, wares::Ware>> possibleTrades;
+        // added after the snapshot was taken
+        if (station == nullptr)
+            continue;
 
-        for (auto const &[wareOwner, offerOwner] : buyOffersOwner)
-        {
-            if (sellOffersStation.find(wareOwner) == sellOffersStation.end())
-                continue;
+        TradeMatches matches = matchOffers(ownerOffers, station->getMarketOffers());
 
-            if (offerOwner.quantity == 0 || sellOffersStation[wareOwner].quantity == 0)
-                continue;
+        if (!matches.any())
+            continue;
 
-            if (sellOffersStation[wareOwner].price > offerOwner.price)
-                continue;
+        return TradeProposal{station->handle, toTradeList(matches)};
+    }
 
-            possibleTrades.push_back({wares::TradeType::Sell, wareOwner});
-        }
+    return std::nullopt;
+}
 
-        for (auto const &[wareOwner, offerOwner] : sellOffersOwner)
-        {
-            if (buyOffersStation.find(wareOwner) == buyOffersStation.end())
-                continue;
+bool Ship::commitTrade(TradeProposal proposal)
+{
+    // every caller only searches for ships without orders, the trade becomes the only order (see addOrder)
+    assert(this->m_Orders.empty());
 
-            if (offerOwner.quantity == 0 || buyOffersStation[wareOwner].quantity == 0)
-                continue;
+    auto &possibleTrades = proposal.trades;
 
-            if (buyOffersStation[wareOwner].price < offerOwner.price)
-                continue;
+    Station *ownerStation = this->m_Manager->getStation(this->owner);
+    Station *station = this->m_Manager->getStation(proposal.station);
 
-            possibleTrades.push_back({wares::TradeType::Buy, wareOwner});
-        }
+    // either side may have been removed since the proposal was made
+    if (ownerStation == nullptr || station == nullptr)
+    {
+        return false;
+    }
 
-        if (possibleTrades.size() == 0)
-            continue;
+    auto &buyOffersOwner = ownerStation->getBuyOffers();
+    auto &sellOffersOwner = ownerStation->getSellOffers();
+    auto &buyOffersStation = station->getBuyOffers();
+    auto &sellOffersStation = station->getSellOffers();
+
+    auto random = this->m_Manager->getRandom(this->id, utils::RandomPurpose::TradeChoice);
 
-        auto &trade = possibleTrades[utils::gen() % possibleTrades.size()];
+    while (possibleTrades.size() > 0)
+    {
+        size_t tradeIndex = random() % possibleTrades.size();
+        auto trade = possibleTrades[tradeIndex];
         wares::TradeType type = trade.first;
         wares::Ware ware = trade.second;
 
-        this->addOrder(orders::Undock{});
+        // the proposal may have been found in an older snapshot of the market, so another ship
+        // could have taken the offer in the meantime
+        if (!matchOffers(ownerStation->getMarketOffers(), station->getMarketOffers()).contains(type, ware))
+        {
+            possibleTrades.erase(possibleTrades.begin() + tradeIndex);
+            continue;
+        }
 
         if (type == wares::TradeType::Buy)
         {
-            int quantity = std::min(sellOffersOwner[ware].quantity, buyOffersStation[ware].quantity);
+            int quantity = std::min(sellOffersOwner.at(ware).quantity, buyOffersStation.at(ware).quantity);
             quantity = std::min(quantity, this->cargoCapacity - this->m_Cargo[ware]);
 
-            this->owner->acceptTrade(wares::TradeType::Sell, ware, quantity);
+            ownerStation->acceptTrade(wares::TradeType::Sell, ware, quantity);
             station->acceptTrade(wares::TradeType::Buy, ware, quantity);
 
-            this->addOrder(orders::DockAtStation{
-                owner,
-            });
-            this->addOrder(orders::TradeWithStation{
-                owner,
-                wares::TradeType::Buy,
-                ware,
-                quantity,
-            });
-            this->addOrder(orders::Undock{});
-            this->addOrder(orders::DockAtStation{
-                station,
-            });
-            this->addOrder(orders::TradeWithStation{
-                station,
-                wares::TradeType::Sell,
-                ware,
-                quantity,
-            });
+            // from the owner to the station
+            this->addOrder(orders::TradeItinerary{this->owner, proposal.station, quantity, ware});
         }
         else if (type == wares::TradeType::Sell)
         {
-            int quantity = std::min(buyOffersOwner[ware].quantity, sellOffersStation[ware].quantity);
+            int quantity = std::min(buyOffersOwner.at(ware).quantity, sellOffersStation.at(ware).quantity);
             quantity = std::min(quantity, this->cargoCapacity - this->m_Cargo[ware]);
 
-            this->owner->acceptTrade(wares::TradeType::Buy, ware, quantity);
+            ownerStation->acceptTrade(wares::TradeType::Buy, ware, quantity);
             station->acceptTrade(wares::TradeType::Sell, ware, quantity);
 
-            this->addOrder(orders::DockAtStation{
-                station,
-            });
-            this->addOrder(orders::TradeWithStation{
-                station,
-                wares::TradeType::Buy,
-                ware,
-                quantity,
-            });
-            this->addOrder(orders::Undock{});
-            this->addOrder(orders::DockAtStation{
-                this->owner,
-            });
-            this->addOrder(orders::TradeWithStation{
-                this->owner,
-                wares::TradeType::Sell,
-                ware,
-                quantity,
-            });
+            // from the station to the owner
+            this->addOrder(orders::TradeItinerary{proposal.station, this->owner, quantity, ware});
         }
 
         this->executeNextOrder();
-        break;
+        return true;
     }
 
-    // this->undock();
-    // this->setTarget(station);
+    return false;
 }
 
 void Ship::addOrder(ShipOrder order)
 {
-    this->m_Orders.push_back(order);
+    assert(this->m_Orders.size() < OrderQueue::CAPACITY);
+    this->m_Orders.push(order);
 }
 
 void Ship::executeNextOrder()
 {
-    if (this->m_Orders.size() == 0)
+    if (this->m_Orders.empty())
     {
+        // idle again
+        this->scheduleTradeCheck();
         return;
     }
 
-    ShipOrder order = this->m_Orders[0];
-    this->m_Orders.erase(this->m_Orders.begin());
+    // copied, running the order can clear the queue
+    ShipOrder order = this->m_Orders.front();
 
-    if (std::holds_alternative<orders::DockAtStation>(order))
+    // an itinerary stays at the front until its last step ran, everything else is done right away
+    auto itinerary = std::get_if<orders::TradeItinerary>(&this->m_Orders.front());
+    if (itinerary == nullptr || !itinerary->advance())
     {
-        auto dockOrder = std::get<orders::DockAtStation>(order);
+        this->m_Orders.pop();
+    }
 
-        assert(this->dockedStation == nullptr);
+    std::visit([this](const auto &order)
+               { this->execute(order); },
+               order);
+}
 
-        this->setTarget(dockOrder.station);
-    }
-    else if (std::holds_alternative<orders::TradeWithStation>(order))
-    {
-        auto tradeOrder = std::get<orders::TradeWithStation>(order);
-        assert(this->dockedStation == tradeOrder.station);
+void Ship::execute(const orders::DockAtStation &order)
+{
+    assert(this->dockedStation.isNull());
 
-        if (tradeOrder.type == wares::TradeType::Buy)
-        {
-            this->dockedStation->transferWares(this->shared_from_this(), tradeOrder.ware, tradeOrder.quantity);
-        }
-        else if (tradeOrder.type == wares::TradeType::Sell)
-        {
-            this->dockedStation->transferWares(this->shared_from_this(), tradeOrder.ware, -tradeOrder.quantity);
-        }
+    this->setTarget(order.station);
+}
 
-        this->executeNextOrder();
+void Ship::execute(const orders::TradeWithStation &order)
+{
+    assert(this->dockedStation == order.station);
 
-        // // transfer wares
-        // if (tradeOrder.type == wares::TradeType::Buy)
-        // {
-        //     this->m_Cargo[tradeOrder.ware] += tradeOrder.quantity;
-        //     this->dockedStation->updateInventory(tradeOrder.ware, -tradeOrder.quantity);
-        // }
-        // else if (tradeOrder.type == wares::TradeType::Sell)
-        // {
-        //     this->m_Cargo[tradeOrder.ware] -= tradeOrder.quantity;
-        // }
+    Station *station = this->m_Manager->getStation(order.station);
+    if (station == nullptr)
+    {
+        // the station is gone, so is the trade
+        this->m_Orders.clear();
+        this->scheduleTradeCheck();
+        return;
     }
-    else if (std::holds_alternative<orders::Undock>(order))
+
+    if (order.type == wares::TradeType::Buy)
     {
-        this->undock();
+        station->transferWares(*this, order.ware, order.quantity);
     }
-    else if (std::holds_alternative<orders::MoveToPosition>(order))
+    else if (order.type == wares::TradeType::Sell)
     {
-        auto moveOrder = std::get<orders::MoveToPosition>(order);
-
-        this->setTarget(moveOrder.position);
+        station->transferWares(*this, order.ware, -order.quantity);
     }
-    else
+
+    this->executeNextOrder();
+}
+
+void Ship::execute(const orders::Undock &)
+{
+    this->undock();
+}
+
+void Ship::execute(const orders::MoveToPosition &order)
+{
+    this->setTarget(order.position);
+}
+
+void Ship::execute(const orders::TradeItinerary &itinerary)
+{
+    using Step = orders::TradeItinerary::Step;
+
+    switch (itinerary.step)
     {
-        throw std::runtime_error("Unknown order type");
+    case Step::Undock:
+    case Step::UndockFromSeller:
+        this->execute(orders::Undock{});
+        break;
+    case Step::DockAtSeller:
+        this->execute(orders::DockAtStation{itinerary.seller});
+        break;
+    case Step::Buy:
+        this->execute(orders::TradeWithStation{itinerary.seller, wares::TradeType::Buy, itinerary.ware, itinerary.quantity});
+        break;
+    case Step::DockAtBuyer:
+        this->execute(orders::DockAtStation{itinerary.buyer});
+        break;
+    case Step::Sell:
+        this->execute(orders::TradeWithStation{itinerary.buyer, wares::TradeType::Sell, itinerary.ware, itinerary.quantity});
+        break;
+    case Step::Done:
+        // popped by executeNextOrder before it gets here
+        break;
     }
 }
 
@@ -280,176 +373,145 @@ void Ship::addWare(Ware ware, int quantity)
     this->m_Cargo[ware] += quantity;
 }
 
-void Ship::undock()
+void Ship::leaveDock()
 {
-    if (this->dockedStation == nullptr)
+    Station *station = this->m_Manager->getStation(this->dockedStation);
+
+    // not docked, or the station is gone (and took the dock with it)
+    if (station != nullptr)
     {
-        executeNextOrder();
-        return;
+        station->undock(*this);
     }
 
-    this->dockedStation->undock(this->shared_from_this());
-    this->dockedStation = nullptr;
+    this->dockedStation = StationHandle();
+    this->m_DockSlot = DockingBay::NO_SLOT;
+}
+
+void Ship::undock()
+{
+    this->leaveDock();
     this->executeNextOrder();
 }
 
 void Ship::setTarget(vec2f target)
 {
     this->m_Target = target;
-
-    assert(this->m_Target.has_value());
+    this->m_Manager->getShipKinematics().setTarget(this, this->body().position, target, this->maxSpeed);
 }
 
-void Ship::setTarget(std::shared_ptr<Station> station)
+void Ship::setTarget(StationHandle stationHandle)
 {
-    assert(station != nullptr);
+    Station *station = this->m_Manager->getStation(stationHandle);
+    if (station == nullptr)
+    {
+        // the station is gone, nothing left to do there
+        this->m_Orders.clear();
+        this->scheduleTradeCheck();
+        return;
+    }
 
     const static float offset = 0;
 
-    const vec2f &stationPosition = station->getPosition();
+    vec2f stationPosition = station->getPosition();
+    vec2f position = this->body().position;
 
-    float deltaX = stationPosition.x - this->m_Position.x;
-    float deltaY = stationPosition.y - this->m_Position.y;
-    float alpha = atan2(deltaY, deltaX);
+    vec2f direction(stationPosition.x - position.x, stationPosition.y - position.y);
+    direction.normalize();
 
-    float x = stationPosition.x - offset * cos(alpha);
-    float y = stationPosition.y - offset * sin(alpha);
+    float x = stationPosition.x - offset * direction.x;
+    float y = stationPosition.y - offset * direction.y;
 
-    this->targetStation = station;
+    this->targetStation = stationHandle;
     this->setTarget(vec2f(x, y));
 }
 
-void Ship::tick(float dt)
+void Ship::arrive()
 {
-    if (this->dockedStation != nullptr)
-    {
-        return;
-    }
-
-    if (!this->m_Target.has_value())
-    {
-        return;
-    }
-
-    vec2f target = this->m_Target.value();
+    this->m_Target.reset();
 
-    float deltaX = target.x - this->m_Position.x;
-    float deltaY = target.y - this->m_Position.y;
-    float distance2 = deltaX * deltaX + deltaY * deltaY;
+    Station *station = this->m_Manager->getStation(this->targetStation);
+    this->targetStation = StationHandle();
 
-    if (distance2 < this->maxSpeed * dt * this->maxSpeed * dt)
+    if (station != nullptr)
     {
-
-        this->m_Position = target;
-
-        this->m_Target.reset();
-
-        if (this->targetStation != nullptr)
-        {
-            auto t = this->targetStation;
-            this->targetStation = nullptr;
-            t->requestDock(this->shared_from_this());
-        }
-
-        return;
+        station->requestDock(*this);
     }
-
-    float alpha = atan2(deltaY, deltaX);
-    this->m_CurrentDirection = alpha;
-
-    float x = this->m_Position.x + this->maxSpeed * dt * cos(alpha);
-    float y = this->m_Position.y + this->maxSpeed * dt * sin(alpha);
-
-    this->m_Position = vec2f(x, y);
 }
 
-void Ship::attack(std::shared_ptr<Ship> target)
+void Ship::attack(Ship &target)
 {
-    while (target->getHullHealth() > 0 && this->getHullHealth() > 0)
-    {
-        if (utils::gen() % 2 == 0)
-        {
-            printf("Ship %d attacking ship %d\n", this->id, target->id);
-            target->doDamage(this->weaponAttack);
-        }
-        else
-        {
-            printf("Ship %d attacking ship %d\n", target->id, this->id);
-            this->doDamage(target->weaponAttack);
-        }
-    }
+    if (!this->canFight())
+        return;
+
+    this->m_Manager->getCombat().engage(this->m_Handle, target.m_Handle);
 }
 
-void Ship::setManager(std::shared_ptr<EntityManager> manager)
+void Ship::setManager(EntityManager *manager)
 {
     this->m_Manager = manager;
 }
 
 void Ship::doDamage(float damage)
 {
-    this->hullHealth -= damage;
+    ShipBody &body = this->body();
+    bool alive = body.hullHealth > 0;
+    body.hullHealth -= damage;
 
-    if (this->hullHealth <= 0)
+    if (alive && body.hullHealth <= 0)
     {
-        this->m_Manager->removeShip(this->shared_from_this());
+        this->m_Manager->getCombat().destroy(this->m_Handle);
     }
 }
 
-void Ship::intercept(std::shared_ptr<Ship> target, float dt)
+vec2f Ship::getVelocity() const
 {
-    vec2f targetPos = target->m_Position;
-
-    float partialFutureTargetPosX = target->maxSpeed * cos(target->m_CurrentDirection);
-    float partialFutureTargetPosY = target->maxSpeed * sin(target->m_CurrentDirection);
-
-    float futureTargetPosX = targetPos.x + partialFutureTargetPosX * dt;
-    float futureTargetPosY = targetPos.y + partialFutureTargetPosY * dt;
-
-    float deltaX = futureTargetPosX - this->m_Position.x;
-    float deltaY = futureTargetPosY - this->m_Position.y;
+    if (!this->m_Target.has_value())
+        return vec2f(0, 0);
 
-    float distance = sqrt(deltaX * deltaX + deltaY * deltaY) - 5;
+    const ShipBody &body = this->body();
+    return vec2f(body.heading.x * this->maxSpeed, body.heading.y * this->maxSpeed);
+}
 
-    if (distance < this->maxSpeed * dt)
+bool Ship::intercept(Ship &target, float dt)
+{
+    // gives the slot back and shows up again, the fight happens outside
+    if (!this->dockedStation.isNull())
     {
-        this->attack(target);
-        return;
+        this->leaveDock();
     }
 
-    float sampleT = 0.01;
-    float t = 0.0;
+    vec2f targetPosition = target.getPosition();
+    vec2f position = this->body().position;
+    vec2f offset(targetPosition.x - position.x, targetPosition.y - position.y);
 
-    while (true)
+    float reach = COMBAT_RANGE + this->maxSpeed * dt;
+    if (offset.x * offset.x + offset.y * offset.y < reach * reach)
     {
-        float futureTargetPosX = targetPos.x + partialFutureTargetPosX * t;
-        float futureTargetPosY = targetPos.y + partialFutureTargetPosY * t;
-
-        float deltaX = futureTargetPosX - this->m_Position.x;
-        float deltaY = futureTargetPosY - this->m_Position.y;
+        return true;
+    }
 
-        float distance = sqrt(deltaX * deltaX + deltaY * deltaY);
-        float timeToIntercept = distance / this->maxSpeed;
+    vec2f targetVelocity = target.getVelocity();
+    auto time = combat::solveInterceptTime(offset, targetVelocity, this->maxSpeed);
 
-        if (timeToIntercept <= t)
-        {
-            this->setTarget(vec2f(futureTargetPosX, futureTargetPosY));
-            break;
-        }
-        else
-        {
-            t += timeToIntercept * 0.2;
-        }
-    }
+    // can't catch up, keep following it in case it slows down
+    float t = time.value_or(0.0f);
+    this->setTarget(vec2f(targetPosition.x + targetVelocity.x * t, targetPosition.y + targetVelocity.y * t));
+    return false;
 }
 
-void Ship::render(vec2f camera, float zoomLevel, vec2f zoomCenter)
+void Ship::render(vec2f camera, float zoomLevel, vec2f zoomCenter, float interpolation)
 {
-    if (this->dockedStation != nullptr)
+    if (!this->dockedStation.isNull())
     {
         return;
     }
 
-    vec2f position = this->m_Position - camera;
+    const ShipBody &body = this->body();
+
+    vec2f interpolatedPosition = vec2f(
+        body.previousPosition.x + (body.position.x - body.previousPosition.x) * interpolation,
+        body.previousPosition.y + (body.position.y - body.previousPosition.y) * interpolation);
+    vec2f position = interpolatedPosition - camera;
 
     SDL_Rect dest;
     dest.x = (position.x - zoomCenter.x) * zoomLevel + zoomCenter.x - 5 * zoomLevel;
@@ -466,7 +528,7 @@ void Ship::render(vec2f camera, float zoomLevel, vec2f zoomCenter)
     static const int maxHealth = 100;
     static const int maxHealthBarWidth = 20;
     SDL_Rect healthBar;
-    healthBar.w = this->hullHealth / 100 * maxHealthBarWidth * zoomLevel;
+    healthBar.w = body.hullHealth / 100 * maxHealthBarWidth * zoomLevel;
     healthBar.h = 5 * zoomLevel;
     healthBar.x = dest.x - (maxHealthBarWidth / 4) * zoomLevel;
     healthBar.y = dest.y + 15 * zoomLevel;
@@ -1,58 +1,124 @@
 #pragma once
 
 #include "vec.hpp"
+#include "components.hpp"
+#include "docking.hpp"
 #include "station.hpp"
 #include "wares.hpp"
 #include "orders.hpp"
+#include "pool.hpp"
+#include "slotMap.hpp"
 
 #include <SDL2/SDL.h>
 
 #include <memory>
 #include <vector>
-#include <map>
 #include <optional>
 
 using wares::Ware;
 
 class Station;
 class EntityManager;
+class MarketSnapshot;
+
+// A station the ship could trade with and the trades it found there, see Ship::findTrade.
+struct TradeProposal
+{
+    StationHandle station;
+    std::vector<std::pair<wares::TradeType, wares::Ware>> trades;
+};
 
 class Ship : public std::enable_shared_from_this<Ship>
 {
 public:
-    Ship(vec2f m_Position, float maxSpeed, float cargoCapacity, float weaponAttack, SDL_Renderer *renderer);
+    Ship(vec2f position, float maxSpeed, float cargoCapacity, float weaponAttack, SDL_Renderer *renderer);
+
+    void claim(StationHandle station);
+    // Called by the station once the ship has a docking slot
+    void dock(Station &station, uint32_t slot);
+    // Gives the docking slot back (if the ship is docked), without running the next order
+    void leaveDock();
+
+    void setManager(EntityManager *manager);
+    // Assigned by EntityManager::addShip
+    void setHandle(ShipHandle handle, int id)
+    {
+        m_Handle = handle;
+        this->id = id;
+    }
+
+    // Called when the ship's trade check fires, schedules the next one
+    void searchForTrade();
+
+    // searchForTrade split up, so the search itself can run in parallel against a snapshot of the market:
+    // readyForTradeSearch is called when the trade check fires and returns whether the ship should look for a trade,
+    // findTrade only reads the snapshot (and the ship), and commitTrade validates the proposal against
+    // the live offers and reserves it. The first and last have to be called serially, followed by scheduleTradeCheck.
+    bool readyForTradeSearch();
+    std::optional<TradeProposal> findTrade(const MarketSnapshot &snapshot) const;
+    bool commitTrade(TradeProposal proposal);
 
-    void claim(std::shared_ptr<Station> station);
-    void dock(std::shared_ptr<Station> station);
+    // Schedules the next trade check on the EntityManager's timers. Ships without an owner don't check,
+    // and a ship with orders waits until it's done with them, the delay only runs while the ship is idle.
+    void scheduleTradeCheck();
 
-    void setManager(std::shared_ptr<EntityManager> manager);
+    // The trade check fired while trades are assigned in batches (see TradeAssigner), the ship
+    // doesn't search on its own and isn't waiting for a check anymore
+    void skipTradeCheck()
+    {
+        m_TradeCheckScheduled = false;
+    }
 
-    void searchForTrade(const std::vector<std::shared_ptr<Station>> &stations, float dt);
+    // Owned, not flying anywhere and without orders, so free to take a trade
+    bool isIdle() const
+    {
+        return !owner.isNull() && m_Orders.empty() && !m_Target.has_value();
+    }
+
+    StationHandle getOwner() const
+    {
+        return owner;
+    }
 
     void addWare(Ware ware, int quantity);
 
+    // The queue holds OrderQueue::CAPACITY orders and doesn't grow. Orders only come from
+    // commitTrade, which adds a single TradeItinerary and only to ships with an empty queue.
     void addOrder(ShipOrder order);
     void executeNextOrder();
 
-    // NOOOO
-    void intercept(std::shared_ptr<Ship> target, float dt);
+    // Not on its way to a station or waiting for a slot there, those ships would dock wherever a
+    // fight takes them. Docked ships without orders can fight, they leave the dock first.
+    bool canFight() const
+    {
+        return m_Orders.empty() && targetStation.isNull();
+    }
+
+    // Starts a fight with the target, it's carried out by the EntityManager's CombatSystem.
+    // Ignored unless the ship canFight.
+    void attack(Ship &target);
+    // Steers towards where the target will be if it keeps its course. True once the target is in weapon range.
+    bool intercept(Ship &target, float dt);
 
+    // A ship without hull left is removed by the CombatSystem at the end of its next resolve
     void doDamage(float damage);
-    // {
-    // hullHealth -= damage;
-
-    // if (hullHealth <= 0)
-    // {
-    //     printf("Ship %d destroyed\n", id);
-    //     this->m_Manager->removeShip(this->shared_from_this());
-    // }
-    // }
 
     const int getId() const
     {
         return id;
     }
 
+    ShipHandle getHandle() const
+    {
+        return m_Handle;
+    }
+
+    // DockingBay::NO_SLOT while not docked
+    uint32_t getDockSlot() const
+    {
+        return m_DockSlot;
+    }
+
     const int getCargoSpace() const
     {
         return cargoCapacity;
@@ -60,32 +126,59 @@ public:
 
     const vec2f getPosition() const
     {
-        return m_Position;
+        return body().position;
     }
 
     const float getDirection() const
     {
-        return m_CurrentDirection;
+        return atan2f(body().heading.y, body().heading.x);
     }
 
     const float getHullHealth() const
     {
-        return hullHealth;
+        return body().hullHealth;
     }
 
-private:
-    int id;
+    const float getWeaponAttack() const
+    {
+        return weaponAttack;
+    }
 
-    std::shared_ptr<Station> owner = nullptr;
-    std::shared_ptr<Station> dockedStation = nullptr;
-    std::shared_ptr<Station> targetStation = nullptr;
+    // Zero unless the ship is flying somewhere
+    vec2f getVelocity() const;
 
-    std::vector<ShipOrder> m_Orders;
-    std::shared_ptr<EntityManager> m_Manager;
+private:
+    // null (and the id 0) until the ship is added to the EntityManager
+    ShipHandle m_Handle;
+    int id = 0;
+
+    // links to other entities are handles, only the EntityManager owns entities
+    StationHandle owner;
+    StationHandle dockedStation;
+    uint32_t m_DockSlot = DockingBay::NO_SLOT;
+    StationHandle targetStation;
+
+    OrderQueue m_Orders;
+    EntityManager *m_Manager = nullptr;
+
+    // position, heading and health live in the EntityManager's ShipComponents while the ship is
+    // registered there, m_Body only holds them before the ship is added and after it's removed
+    ShipBody m_Body;
+    ShipComponents *m_Components = nullptr;
+    size_t m_ComponentIndex = 0;
+
+    ShipBody &body()
+    {
+        return m_Components ? m_Components->getBody(m_ComponentIndex) : m_Body;
+    }
+    const ShipBody &body() const
+    {
+        return m_Components ? m_Components->getBody(m_ComponentIndex) : m_Body;
+    }
 
-    vec2f m_Position;
-    float m_CurrentDirection;
     std::optional<vec2f> m_Target;
+    // slot in the ShipKinematics while the ship is in flight, -1 otherwise
+    int m_KinematicsIndex = -1;
 
     SDL_Renderer *m_Renderer;
 
@@ -93,28 +186,37 @@ private:
     const int cargoCapacity;
     const float weaponAttack;
 
-    float m_TimeUntilNextTradeCheck = 0.0f;
+    // delay of the next trade check, counted from when the ship runs out of orders
+    float m_TradeCheckDelay = 0.0f;
+    bool m_TradeCheckScheduled = false;
 
-    float hullHealth = 100.0f;
-
-    std::map<Ware, int> m_Cargo;
+    wares::WareArray<int> m_Cargo;
 
     void undock();
 
+    // executeNextOrder dispatches to these
+    void execute(const orders::DockAtStation &order);
+    void execute(const orders::TradeWithStation &order);
+    void execute(const orders::Undock &order);
+    void execute(const orders::MoveToPosition &order);
+    void execute(const orders::TradeItinerary &itinerary);
+
     void setTarget(vec2f target);
-    void setTarget(std::shared_ptr<Station> station);
+    void setTarget(StationHandle station);
 
-    void attack(std::shared_ptr<Ship> target);
+    friend class ShipKinematics;
+    friend class ShipComponents;
 
 public:
-    void render(vec2f camera, float zoomLevel, vec2f zoomCenter);
-    void tick(float dt);
+    void render(vec2f camera, float zoomLevel, vec2f zoomCenter, float interpolation);
+    // Called once the ShipKinematics moved the ship onto its target
+    void arrive();
 };
 
 namespace ShipPreset
 {
     inline std::shared_ptr<Ship> createFreighter(vec2f position, SDL_Renderer *renderer)
     {
-        return std::make_shared<Ship>(position, 100, 1000, 0.1, renderer);
+        return makePooled<Ship>(position, 100, 1000, 0.1, renderer);
     }
 }
\ No newline at end of file
@@ -0,0 +1,191 @@
+#include "shipKinematics.hpp"
+#include "ship.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// SSE2 is part of x86-64, everything else (or a build with it turned off) uses the scalar loop
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SHIP_KINEMATICS_SSE 1
+#include <emmintrin.h>
+#endif
+
+void ShipKinematics::setTarget(Ship *ship, vec2f position, vec2f target, float speed)
+{
+    if (ship->m_KinematicsIndex >= 0)
+    {
+        size_t index = static_cast<size_t>(ship->m_KinematicsIndex);
+        m_TargetX[index] = target.x;
+        m_TargetY[index] = target.y;
+        m_Speed[index] = speed;
+        return;
+    }
+
+    ship->m_KinematicsIndex = static_cast<int>(m_Ships.size());
+
+    m_PositionX.push_back(position.x);
+    m_PositionY.push_back(position.y);
+    m_TargetX.push_back(target.x);
+    m_TargetY.push_back(target.y);
+    m_Speed.push_back(speed);
+    vec2f heading = ship->body().heading;
+    m_HeadingX.push_back(heading.x);
+    m_HeadingY.push_back(heading.y);
+    m_Ships.push_back(ship);
+}
+
+void ShipKinematics::remove(Ship *ship)
+{
+    m_Settling.erase(std::remove(m_Settling.begin(), m_Settling.end(), ship), m_Settling.end());
+
+    if (ship->m_KinematicsIndex < 0)
+        return;
+
+    removeAt(static_cast<size_t>(ship->m_KinematicsIndex));
+}
+
+void ShipKinematics::removeAt(size_t index)
+{
+    size_t last = m_Ships.size() - 1;
+
+    m_Ships[index]->m_KinematicsIndex = -1;
+
+    if (index != last)
+    {
+        m_PositionX[index] = m_PositionX[last];
+        m_PositionY[index] = m_PositionY[last];
+        m_TargetX[index] = m_TargetX[last];
+        m_TargetY[index] = m_TargetY[last];
+        m_Speed[index] = m_Speed[last];
+        m_HeadingX[index] = m_HeadingX[last];
+        m_HeadingY[index] = m_HeadingY[last];
+        m_Ships[index] = m_Ships[last];
+        m_Ships[index]->m_KinematicsIndex = static_cast<int>(index);
+    }
+
+    m_PositionX.pop_back();
+    m_PositionY.pop_back();
+    m_TargetX.pop_back();
+    m_TargetY.pop_back();
+    m_Speed.pop_back();
+    m_HeadingX.pop_back();
+    m_HeadingY.pop_back();
+    m_Ships.pop_back();
+}
+
+void ShipKinematics::step(float dt, std::vector<Ship *> &arrivals)
+{
+    // ships that arrived last step stood still since, so they don't interpolate anymore
+    for (Ship *ship : m_Settling)
+    {
+        ShipBody &body = ship->body();
+        body.previousPosition = body.position;
+    }
+    m_Settling.clear();
+
+    size_t count = m_Ships.size();
+    m_Arrived.resize(count);
+
+    float *positionX = m_PositionX.data();
+    float *positionY = m_PositionY.data();
+    const float *targetX = m_TargetX.data();
+    const float *targetY = m_TargetY.data();
+    const float *speed = m_Speed.data();
+    float *headingX = m_HeadingX.data();
+    float *headingY = m_HeadingY.data();
+
+    size_t i = 0;
+
+#ifdef SHIP_KINEMATICS_SSE
+    const __m128 dtVector = _mm_set1_ps(dt);
+    const __m128 zero = _mm_setzero_ps();
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(positionX + i);
+        __m128 y = _mm_loadu_ps(positionY + i);
+        __m128 toX = _mm_loadu_ps(targetX + i);
+        __m128 toY = _mm_loadu_ps(targetY + i);
+        __m128 deltaX = _mm_sub_ps(toX, x);
+        __m128 deltaY = _mm_sub_ps(toY, y);
+        __m128 distance2 = _mm_add_ps(_mm_mul_ps(deltaX, deltaX), _mm_mul_ps(deltaY, deltaY));
+        __m128 stepLength = _mm_mul_ps(_mm_loadu_ps(speed + i), dtVector);
+
+        __m128 arrived = _mm_or_ps(_mm_cmplt_ps(distance2, _mm_mul_ps(stepLength, stepLength)), _mm_cmpeq_ps(distance2, zero));
+
+        // arrived lanes may divide by zero here, they take the target instead
+        __m128 distance = _mm_sqrt_ps(distance2);
+        __m128 newHeadingX = _mm_div_ps(deltaX, distance);
+        __m128 newHeadingY = _mm_div_ps(deltaY, distance);
+        __m128 movedX = _mm_add_ps(x, _mm_mul_ps(newHeadingX, stepLength));
+        __m128 movedY = _mm_add_ps(y, _mm_mul_ps(newHeadingY, stepLength));
+
+        x = _mm_or_ps(_mm_and_ps(arrived, toX), _mm_andnot_ps(arrived, movedX));
+        y = _mm_or_ps(_mm_and_ps(arrived, toY), _mm_andnot_ps(arrived, movedY));
+        newHeadingX = _mm_or_ps(_mm_and_ps(arrived, _mm_loadu_ps(headingX + i)), _mm_andnot_ps(arrived, newHeadingX));
+        newHeadingY = _mm_or_ps(_mm_and_ps(arrived, _mm_loadu_ps(headingY + i)), _mm_andnot_ps(arrived, newHeadingY));
+
+        _mm_storeu_ps(positionX + i, x);
+        _mm_storeu_ps(positionY + i, y);
+        _mm_storeu_ps(headingX + i, newHeadingX);
+        _mm_storeu_ps(headingY + i, newHeadingY);
+
+        int arrivedMask = _mm_movemask_ps(arrived);
+        for (size_t lane = 0; lane < 4; lane++)
+        {
+            m_Arrived[i + lane] = (arrivedMask >> lane) & 1;
+        }
+    }
+#endif
+
+    // the same math one ship at a time, for the ships that don't fill a vector (or without SSE)
+    for (; i < count; i++)
+    {
+        float deltaX = targetX[i] - positionX[i];
+        float deltaY = targetY[i] - positionY[i];
+        float distance2 = deltaX * deltaX + deltaY * deltaY;
+        float stepLength = speed[i] * dt;
+
+        if (distance2 < stepLength * stepLength || distance2 == 0)
+        {
+            positionX[i] = targetX[i];
+            positionY[i] = targetY[i];
+            m_Arrived[i] = 1;
+            continue;
+        }
+
+        float distance = std::sqrt(distance2);
+        headingX[i] = deltaX / distance;
+        headingY[i] = deltaY / distance;
+        positionX[i] += headingX[i] * stepLength;
+        positionY[i] += headingY[i] * stepLength;
+        m_Arrived[i] = 0;
+    }
+
+    size_t firstArrival = arrivals.size();
+
+    for (i = 0; i < count; i++)
+    {
+        Ship *ship = m_Ships[i];
+        ShipBody &body = ship->body();
+        body.previousPosition = body.position;
+        body.position = vec2f(positionX[i], positionY[i]);
+        body.heading = vec2f(headingX[i], headingY[i]);
+
+        if (m_Arrived[i])
+        {
+            arrivals.push_back(ship);
+        }
+    }
+
+    // back to front, so the ships swapped into the removed slots have already been looked at
+    for (i = count; i-- > 0;)
+    {
+        if (m_Arrived[i])
+        {
+            removeAt(i);
+        }
+    }
+
+    m_Settling.insert(m_Settling.end(), arrivals.begin() + firstArrival, arrivals.end());
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "vec.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Ship;
+
+// Movement of the ships that are actually flying somewhere, kept in packed arrays so a whole tick
+// of movement is one pass over contiguous memory (four ships at a time with SSE). Ships join when
+// they get a target and leave when they arrive, so docked and idle ships cost nothing per tick.
+// Headings are unit vectors instead of angles, so moving a ship needs no trig.
+// EntityManager owns the set; the ships' bodies (see ShipComponents) are updated after every step.
+class ShipKinematics
+{
+public:
+    // Starts moving a ship towards a target, or changes the target of a ship already in flight
+    void setTarget(Ship *ship, vec2f position, vec2f target, float speed);
+    void remove(Ship *ship);
+
+    // Moves every ship in flight by dt. Ships that reach their target leave the set and are
+    // appended to arrivals, in a deterministic order, for the caller to handle (e.g. docking).
+    void step(float dt, std::vector<Ship *> &arrivals);
+
+    size_t size() const
+    {
+        return m_Ships.size();
+    }
+
+private:
+    std::vector<float> m_PositionX;
+    std::vector<float> m_PositionY;
+    std::vector<float> m_TargetX;
+    std::vector<float> m_TargetY;
+    std::vector<float> m_Speed;
+    std::vector<float> m_HeadingX;
+    std::vector<float> m_HeadingY;
+    std::vector<uint8_t> m_Arrived;
+    std::vector<Ship *> m_Ships;
+
+    // ships that arrived in the last step, their previous position still has to catch up
+    std::vector<Ship *> m_Settling;
+
+    void removeAt(size_t index);
+};
@@ -0,0 +1,187 @@
+// Headless simulation runner. Builds the same world as the game, but never touches SDL video,
+// and steps it as fast as possible. Reports the simulation throughput when it exits.
+//
+// Usage: fourx_sim [--duration <simulated seconds>] [--dt <seconds per tick>] [--threads <count>] [--parallel-trade] [--batch-trade] [--seed <world seed>] [--trace <file>]
+//                  [--metrics <file>] [--metrics-interval <simulated seconds>]
+
+#include "../simulation.hpp"
+#include "../profiler.hpp"
+#include "../metrics.hpp"
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+static volatile std::sig_atomic_t g_Quit = 0;
+
+static void handleSignal(int)
+{
+    g_Quit = 1;
+}
+
+static void printReport(const Simulation &simulation, double wallTime)
+{
+    auto &timings = simulation.getPhaseTimings();
+    auto entityManager = simulation.getEntityManager();
+
+    double simulatedTime = simulation.getSimulatedTime();
+    uint64_t ticks = simulation.getTickCount();
+
+    printf("\n=========== simulation report ===========\n");
+    printf("world seed:             %llu\n", static_cast<unsigned long long>(entityManager->getWorldSeed()));
+    printf("ticks:                  %llu\n", static_cast<unsigned long long>(ticks));
+    printf("simulated time:         %.2f s\n", simulatedTime);
+    printf("wall-clock time:        %.2f s\n", wallTime);
+    printf("sim seconds / wall sec: %.2f\n", wallTime > 0 ? simulatedTime / wallTime : 0.0);
+    printf("ticks / wall second:    %.2f\n", wallTime > 0 ? ticks / wallTime : 0.0);
+    printf("stations:               %zu\n", entityManager->getStations().size());
+    printf("ships:                  %zu\n", entityManager->getShips().size());
+    printf("threads:                %zu\n", simulation.getThreadCount());
+
+    printf("\nphase                  total (s)   avg per tick (ms)\n");
+
+    auto printPhase = [&](const char *name, double total)
+    {
+        printf("%-22s %10.3f   %17.4f\n", name, total, ticks > 0 ? total * 1000.0 / ticks : 0.0);
+    };
+
+    printPhase("stations", timings.stations);
+    printPhase("ships", timings.ships);
+    printPhase("shipPurchaseCheck", timings.shipPurchaseCheck);
+    printPhase("tradeAssignment", timings.tradeAssignment);
+    printPhase("combat", timings.combat);
+
+    printf("\ncounter                        total   per simulated second\n");
+    for (auto counter : metrics::getCounters())
+    {
+        printf("%-28s %8lld   %20.2f\n", counter->getName(), static_cast<long long>(counter->get()),
+               simulatedTime > 0 ? counter->get() / simulatedTime : 0.0);
+    }
+    printf("=========================================\n");
+}
+
+int main(int argc, char *argv[])
+{
+    double duration = 600.0;
+    float dt = SIM_TIMESTEP;
+    int threads = 0;
+    bool parallelTradeSearch = false;
+    bool batchTradeAssignment = false;
+    const char *tracePath = nullptr;
+    const char *metricsPath = nullptr;
+    float metricsInterval = 10.0f;
+    uint64_t worldSeed = (static_cast<uint64_t>(std::random_device{}()) << 32) | std::random_device{}();
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc)
+        {
+            duration = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--dt") == 0 && i + 1 < argc)
+        {
+            dt = static_cast<float>(atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            worldSeed = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+        {
+            tracePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc)
+        {
+            metricsPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--metrics-interval") == 0 && i + 1 < argc)
+        {
+            metricsInterval = static_cast<float>(atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--parallel-trade") == 0)
+        {
+            parallelTradeSearch = true;
+        }
+        else if (strcmp(argv[i], "--batch-trade") == 0)
+        {
+            batchTradeAssignment = true;
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [--duration <simulated seconds>] [--dt <seconds per tick>] [--threads <count>] [--parallel-trade] [--batch-trade] [--seed <world seed>] [--trace <file>] [--metrics <file>] [--metrics-interval <simulated seconds>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (dt <= 0)
+    {
+        fprintf(stderr, "--dt must be positive\n");
+        return 1;
+    }
+
+    if (metricsInterval <= 0)
+    {
+        fprintf(stderr, "--metrics-interval must be positive\n");
+        return 1;
+    }
+
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+
+    Simulation simulation(nullptr, nullptr, nullptr, worldSeed);
+    if (threads > 0)
+    {
+        simulation.setThreadCount(threads);
+    }
+    simulation.setParallelTradeSearch(parallelTradeSearch);
+    simulation.setBatchTradeAssignment(batchTradeAssignment);
+    simulation.setTimestep(dt);
+    simulation.initializeEntities();
+
+    if (metricsPath && !simulation.openMetricsOutput(metricsPath, metricsInterval))
+    {
+        fprintf(stderr, "Failed to open %s\n", metricsPath);
+        return 1;
+    }
+
+    if (tracePath)
+    {
+        profiler::setEnabled(true);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    while (!g_Quit && simulation.getSimulatedTime() < duration)
+    {
+        PROFILE_ZONE("Simulation::tick");
+        simulation.tick(dt);
+    }
+
+    double wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // final snapshot, so the file always ends with the totals
+    simulation.writeMetricsSnapshot();
+    printReport(simulation, wallTime);
+
+    if (tracePath)
+    {
+        profiler::setEnabled(false);
+
+        if (!profiler::writeChromeTrace(tracePath))
+        {
+            fprintf(stderr, "Failed to write trace to %s\n", tracePath);
+            return 1;
+        }
+
+        printf("Trace written to %s\n", tracePath);
+    }
+
+    return 0;
+}
@@ -0,0 +1,356 @@
+#include "simulation.hpp"
+#include "config.hpp"
+#include "productionStation.hpp"
+#include "productionModule.hpp"
+#include "ship.hpp"
+#include "warfStation.hpp"
+#include "utils.hpp"
+#include "profiler.hpp"
+#include "metrics.hpp"
+#include "pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+Simulation::Simulation(std::shared_ptr<UI> ui, SDL_Renderer *renderer, TTF_Font *font, uint64_t worldSeed) : m_UI(ui), m_Renderer(renderer), m_Font(font)
+{
+    m_EntityManager = std::make_shared<EntityManager>();
+    m_EntityManager->setWorldSeed(worldSeed);
+    setThreadCount(std::thread::hardware_concurrency());
+}
+
+Simulation::~Simulation()
+{
+    closeMetricsOutput();
+}
+
+void Simulation::setThreadCount(size_t threadCount)
+{
+    m_ThreadPool = std::make_shared<ThreadPool>(threadCount);
+}
+
+void Simulation::setBatchTradeAssignment(bool enabled)
+{
+    if (m_BatchTradeAssignment && !enabled)
+    {
+        // the checks that fired in the meantime were skipped, idle ships start checking again
+        for (auto &ship : m_EntityManager->getShips())
+        {
+            ship->scheduleTradeCheck();
+        }
+    }
+
+    m_BatchTradeAssignment = enabled;
+}
+
+void Simulation::initializeEntities()
+{
+    // world generation happens serially before the first tick, so a single stream will do
+    auto random = m_EntityManager->getRandom(0, utils::RandomPurpose::WorldGeneration);
+
+    m_EntityManager->getTimers().schedule(SHIP_PURCHASE_CHECK_INTERVAL, timers::ShipPurchaseCheck{});
+
+    for (uint i = 0; i < 1000; i++)
+    {
+        float x = static_cast<float>(random() % 50000) - 25000.0f;
+        float y = static_cast<float>(random() % 50000) - 25000.0f;
+        auto station = ProductionStationPreset::createSiliconWaferProductionStation(vec2f(x, y), "Silicon Wafer Production " + std::to_string(i), m_EntityManager, m_UI, m_Renderer, m_Font);
+        m_EntityManager->addStation(station);
+    }
+
+    for (uint i = 0; i < 1000; i++)
+    {
+        float x = static_cast<float>(random() % 50000) - 25000.0f;
+        float y = static_cast<float>(random() % 50000) - 25000.0f;
+
+        auto ship = ShipPreset::createFreighter(vec2f(x, y), m_Renderer);
+        auto station = ProductionStationPreset::createSiliconProductionStation(vec2f(x, y), "Silicon Production " + std::to_string(i), m_EntityManager, m_UI, m_Renderer, m_Font);
+
+        m_EntityManager->addShip(ship);
+        station->addShip(*ship);
+
+        m_EntityManager->addStation(station);
+    }
+
+    auto warfStation1 = makePooled<WarfStation>(vec2f(500, 400), "Warf Station 1", m_EntityManager, m_UI, m_Renderer, m_Font);
+    warfStation1->setMaintenanceLevel(Ware::SiliconWafers, 100000);
+
+    auto ship = ShipPreset::createFreighter(vec2f(500, 500), m_Renderer);
+    m_EntityManager->addShip(ship);
+
+    warfStation1->addShip(*ship);
+
+    m_EntityManager->addWarfStation(warfStation1);
+}
+
+void Simulation::tick(float dt)
+{
+    m_EntityManager->setTick(m_TickCount);
+    m_EntityManager->getTimers().setTickLength(dt);
+
+    // production, construction and trade checks only do something when their timer fires
+    m_FiredTimers.clear();
+    m_EntityManager->getTimers().advance(m_FiredTimers);
+
+    auto phaseStart = Clock::now();
+
+    tickStations(dt);
+
+    m_PhaseTimings.stations += secondsSince(phaseStart);
+
+    if (m_BatchTradeAssignment)
+    {
+        m_TimeUntilTradeAssignment -= dt;
+        if (m_TimeUntilTradeAssignment <= 0)
+        {
+            phaseStart = Clock::now();
+
+            m_TimeUntilTradeAssignment += TRADE_ASSIGNMENT_INTERVAL;
+            m_TradeAssigner.assign(*m_EntityManager, *m_ThreadPool);
+
+            m_PhaseTimings.tradeAssignment += secondsSince(phaseStart);
+        }
+    }
+
+    phaseStart = Clock::now();
+
+    if (m_ParallelTradeSearch && !m_BatchTradeAssignment)
+    {
+        tickShipsWithParallelTradeSearch(dt);
+    }
+    else
+    {
+        tickShips(dt);
+    }
+
+    m_PhaseTimings.ships += secondsSince(phaseStart);
+
+    // after the ships moved, so destroyed ships can be removed safely
+    phaseStart = Clock::now();
+    {
+        PROFILE_ZONE("Combat");
+        m_EntityManager->getCombat().resolve(*m_EntityManager, dt);
+    }
+    m_PhaseTimings.combat += secondsSince(phaseStart);
+
+    for (auto &event : m_FiredTimers)
+    {
+        if (!std::holds_alternative<timers::ShipPurchaseCheck>(event))
+            continue;
+
+        phaseStart = Clock::now();
+
+        m_EntityManager->getTimers().schedule(SHIP_PURCHASE_CHECK_INTERVAL, timers::ShipPurchaseCheck{});
+
+        PROFILE_ZONE("shipPurchaseCheck");
+        shipPurchaseCheck(m_EntityManager);
+
+        m_PhaseTimings.shipPurchaseCheck += secondsSince(phaseStart);
+    }
+
+    m_SimulatedTime += dt;
+    m_TickCount++;
+
+    if (m_MetricsFile)
+    {
+        m_TimeUntilMetricsSnapshot -= dt;
+        if (m_TimeUntilMetricsSnapshot <= 0)
+        {
+            m_TimeUntilMetricsSnapshot += m_MetricsInterval;
+            writeMetricsSnapshot();
+        }
+    }
+}
+
+bool Simulation::openMetricsOutput(const std::string &path, float intervalSeconds)
+{
+    closeMetricsOutput();
+
+    m_MetricsFile = fopen(path.c_str(), "a");
+    m_MetricsInterval = intervalSeconds;
+    m_TimeUntilMetricsSnapshot = intervalSeconds;
+
+    return m_MetricsFile != nullptr;
+}
+
+void Simulation::closeMetricsOutput()
+{
+    if (!m_MetricsFile)
+        return;
+
+    fclose(m_MetricsFile);
+    m_MetricsFile = nullptr;
+}
+
+void Simulation::writeMetricsSnapshot()
+{
+    if (!m_MetricsFile)
+        return;
+
+    updateGauges();
+    metrics::writeSnapshot(m_MetricsFile, m_SimulatedTime);
+}
+
+void Simulation::updateGauges()
+{
+    size_t dockedShips = 0;
+    size_t dockQueueDepth = 0;
+    size_t maxDockQueueDepth = 0;
+    for (auto &station : m_EntityManager->getStations())
+    {
+        dockedShips += station->getDockedShipCount();
+        dockQueueDepth += station->getDockQueueSize();
+        maxDockQueueDepth = std::max(maxDockQueueDepth, station->getDockQueueSize());
+    }
+
+    metrics::stations.set(m_EntityManager->getStations().size());
+    metrics::ships.set(m_EntityManager->getShips().size());
+    metrics::shipsInFlight.set(m_EntityManager->getShipKinematics().size());
+    metrics::dockedShips.set(dockedShips);
+    metrics::dockQueueDepth.set(dockQueueDepth);
+    metrics::maxDockQueueDepth.set(maxDockQueueDepth);
+    metrics::engagements.set(m_EntityManager->getCombat().getEngagementCount());
+    metrics::scheduledTimers.set(m_EntityManager->getTimers().size());
+}
+
+void Simulation::tickStations(float dt)
+{
+    PROFILE_ZONE("Stations");
+
+    // finished production cycles and ship construction, serially, there are only a handful per tick
+    {
+        PROFILE_ZONE("Station timers");
+        for (auto &event : m_FiredTimers)
+        {
+            auto stationTimer = std::get_if<timers::StationTimer>(&event);
+            if (stationTimer == nullptr)
+                continue;
+
+            // nullptr if the station was removed since it scheduled the timer
+            Station *station = m_EntityManager->getStation(stationTimer->station);
+            if (station != nullptr)
+            {
+                station->onTimer(stationTimer->id, m_Commands);
+            }
+        }
+
+        // the stations may still be iterated while their timers fire, so ships are only added now
+        m_Commands.apply(m_EntityManager);
+    }
+
+    // stations reevaluate their offers as soon as their stock changes, so apart from the timers
+    // only the periodic repricing is left
+    m_TimeUntilPriceUpdate -= dt;
+    if (m_TimeUntilPriceUpdate <= 0)
+    {
+        m_TimeUntilPriceUpdate += PRICE_UPDATE_INTERVAL;
+
+        PROFILE_ZONE("StationComponents::updatePrices");
+        m_EntityManager->getStationComponents().updatePrices(m_EntityManager->getOrderBook());
+    }
+}
+
+void Simulation::tickShips(float dt)
+{
+    PROFILE_ZONE("Ships");
+
+    // with batch assignment, ships get their trades from the TradeAssigner and their trade checks
+    // lapse, setBatchTradeAssignment schedules them again when it's turned off
+    for (auto &event : m_FiredTimers)
+    {
+        auto tradeCheck = std::get_if<timers::TradeCheck>(&event);
+        if (tradeCheck == nullptr)
+            continue;
+
+        Ship *ship = m_EntityManager->getShip(tradeCheck->ship);
+        if (ship == nullptr)
+            continue;
+
+        if (m_BatchTradeAssignment)
+        {
+            ship->skipTradeCheck();
+        }
+        else
+        {
+            ship->searchForTrade();
+        }
+    }
+
+    moveShips(dt);
+}
+
+void Simulation::moveShips(float dt)
+{
+    PROFILE_ZONE("Move ships");
+
+    m_ShipArrivals.clear();
+    m_EntityManager->getShipKinematics().step(dt, m_ShipArrivals);
+
+    // docking can start the next order and send the ship off again, so arrivals are handled after the step
+    for (Ship *ship : m_ShipArrivals)
+    {
+        ship->arrive();
+    }
+}
+
+void Simulation::tickShipsWithParallelTradeSearch(float dt)
+{
+    PROFILE_ZONE("Ships");
+
+    if (!m_HasMarketSnapshot)
+    {
+        m_MarketSnapshot.capture(*m_EntityManager, *m_ThreadPool);
+        m_HasMarketSnapshot = true;
+    }
+
+    std::vector<Ship *> searchingShips;
+    for (auto &event : m_FiredTimers)
+    {
+        auto tradeCheck = std::get_if<timers::TradeCheck>(&event);
+        if (tradeCheck == nullptr)
+            continue;
+
+        Ship *ship = m_EntityManager->getShip(tradeCheck->ship);
+        if (ship != nullptr && ship->readyForTradeSearch())
+        {
+            searchingShips.push_back(ship);
+        }
+    }
+
+    const MarketSnapshot &snapshot = m_MarketSnapshot;
+    std::vector<std::optional<TradeProposal>> proposals(searchingShips.size());
+
+    m_ThreadPool->parallelFor(searchingShips.size(), [&](size_t begin, size_t end, size_t)
+                              {
+        PROFILE_ZONE("Ship::findTrade chunk");
+
+        for (size_t i = begin; i < end; i++)
+        {
+            proposals[i] = searchingShips[i]->findTrade(snapshot);
+        } });
+
+    // commit serially, a ship that lost its trade to a ship before it simply tries again at its next check
+    for (size_t i = 0; i < searchingShips.size(); i++)
+    {
+        if (proposals[i].has_value())
+        {
+            searchingShips[i]->commitTrade(std::move(proposals[i].value()));
+        }
+
+        searchingShips[i]->scheduleTradeCheck();
+    }
+
+    moveShips(dt);
+
+    PROFILE_ZONE("MarketSnapshot::capture");
+    // for the next tick's searches, nothing reads the snapshot while it is captured
+    m_MarketSnapshot.capture(*m_EntityManager, *m_ThreadPool);
+}
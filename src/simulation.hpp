@@ -0,0 +1,149 @@
+#pragma once
+
+#include "config.hpp"
+#include "entityManager.hpp"
+#include "commandBuffer.hpp"
+#include "marketSnapshot.hpp"
+#include "threadPool.hpp"
+#include "tradeAssignment.hpp"
+#include "ui.hpp"
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdio>
+
+#define SHIP_PURCHASE_CHECK_INTERVAL 5.0f
+
+// Upper bound on the steps taken for a single frame, so a slow frame can't snowball into slower ones
+#define MAX_SIM_STEPS_PER_FRAME 5
+
+// Accumulated wall-clock time (in seconds) spent in each phase of Simulation::tick.
+struct SimulationPhaseTimings
+{
+    double stations = 0;
+    double ships = 0;
+    double shipPurchaseCheck = 0;
+    double tradeAssignment = 0;
+    double combat = 0;
+};
+
+// Owns the world and advances it. Doesn't render anything, so it can be driven either by
+// the windowed Game or by the headless fourx_sim runner. When running headless, pass nullptr
+// for the UI, renderer and font. All randomness is derived from the world seed, so two runs
+// with the same seed and timestep produce the same world and economy.
+class Simulation
+{
+public:
+    Simulation(std::shared_ptr<UI> ui, SDL_Renderer *renderer, TTF_Font *font, uint64_t worldSeed);
+    ~Simulation();
+
+    void initializeEntities();
+    void tick(float dt);
+
+    // Length of a tick in simulated seconds, so timers (production cycles, trade checks and so on)
+    // are scheduled in simulated time. tick picks up its dt as well, but call this before
+    // initializeEntities when stepping with something other than SIM_TIMESTEP, so the timers
+    // scheduled while building the world come out right too.
+    void setTimestep(float dt)
+    {
+        m_EntityManager->getTimers().setTickLength(dt);
+    }
+
+    // Number of threads the parallel trade search, the market snapshots and the batch trade
+    // assignment are spread over (including the calling thread). Defaults to the number of hardware threads.
+    void setThreadCount(size_t threadCount);
+    size_t getThreadCount() const
+    {
+        return m_ThreadPool->getThreadCount();
+    }
+
+    // Appends a metrics snapshot (see metrics::writeSnapshot) to the file every intervalSeconds
+    // of simulated time. Returns false if the file couldn't be opened.
+    bool openMetricsOutput(const std::string &path, float intervalSeconds);
+    void closeMetricsOutput();
+    bool isWritingMetrics() const
+    {
+        return m_MetricsFile != nullptr;
+    }
+    // Updates the world gauges and writes a snapshot right away
+    void writeMetricsSnapshot();
+
+    // When enabled, all trade searches of a tick run in parallel against a snapshot of the market
+    // taken at the end of the previous tick, and are then committed one by one. Off by default.
+    void setParallelTradeSearch(bool enabled)
+    {
+        m_ParallelTradeSearch = enabled;
+    }
+
+    // When enabled, ships stop looking for trades on their own. Instead every TRADE_ASSIGNMENT_INTERVAL
+    // all idle ships get trades assigned at once, see TradeAssigner. Off by default.
+    void setBatchTradeAssignment(bool enabled);
+
+    std::shared_ptr<EntityManager> getEntityManager() const
+    {
+        return m_EntityManager;
+    }
+
+    double getSimulatedTime() const
+    {
+        return m_SimulatedTime;
+    }
+
+    uint64_t getTickCount() const
+    {
+        return m_TickCount;
+    }
+
+    const SimulationPhaseTimings &getPhaseTimings() const
+    {
+        return m_PhaseTimings;
+    }
+
+private:
+    std::shared_ptr<EntityManager> m_EntityManager = nullptr;
+    std::shared_ptr<UI> m_UI = nullptr;
+
+    SDL_Renderer *m_Renderer = nullptr;
+    TTF_Font *m_Font = nullptr;
+
+    double m_SimulatedTime = 0;
+    uint64_t m_TickCount = 0;
+    float m_TimeUntilPriceUpdate = 0;
+
+    SimulationPhaseTimings m_PhaseTimings;
+
+    // timers due this tick, see TimerWheel
+    std::vector<TimerEvent> m_FiredTimers;
+
+    void tickStations(float dt);
+    void tickShips(float dt);
+    void tickShipsWithParallelTradeSearch(float dt);
+    void moveShips(float dt);
+
+    void updateGauges();
+
+    FILE *m_MetricsFile = nullptr;
+    float m_MetricsInterval = 0;
+    float m_TimeUntilMetricsSnapshot = 0;
+
+    bool m_BatchTradeAssignment = false;
+    float m_TimeUntilTradeAssignment = 0;
+    TradeAssigner m_TradeAssigner;
+
+    bool m_ParallelTradeSearch = false;
+    // captured at the end of every tick for the searches of the next one
+    MarketSnapshot m_MarketSnapshot;
+    bool m_HasMarketSnapshot = false;
+
+    // reused every tick
+    std::vector<Ship *> m_ShipArrivals;
+
+    std::shared_ptr<ThreadPool> m_ThreadPool = nullptr;
+    // ships spawned by station timers, added once all of them fired
+    CommandBuffer m_Commands;
+};
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+// Stable reference to an entity in a SlotMap: the index of its slot plus the generation the slot
+// had when the entity got it. Removing an entity bumps its slot's generation, so old handles stop
+// resolving instead of pointing at whatever reuses the slot. Generations get a full 32 bits, a
+// slot would have to be reused 4 billion times before an old handle could resolve again.
+template <typename T>
+class Handle
+{
+public:
+    static const uint32_t MAX_INDEX = UINT32_MAX;
+    static const uint32_t MAX_GENERATION = UINT32_MAX;
+
+    // The null handle, never resolves
+    Handle() = default;
+
+    Handle(uint32_t index, uint32_t generation) : m_Index(index), m_Generation(generation) {}
+
+    uint32_t getIndex() const
+    {
+        return m_Index;
+    }
+    uint32_t getGeneration() const
+    {
+        return m_Generation;
+    }
+
+    // Generations start at 1, so only the null handle has generation 0
+    bool isNull() const
+    {
+        return getGeneration() == 0;
+    }
+
+    bool operator==(const Handle &other) const
+    {
+        return m_Index == other.m_Index && m_Generation == other.m_Generation;
+    }
+    bool operator!=(const Handle &other) const
+    {
+        return !(*this == other);
+    }
+
+private:
+    // two halves rather than one uint64_t, so handles only need 4 byte alignment and pack
+    // tightly into orders and timers
+    uint32_t m_Index = 0;
+    uint32_t m_Generation = 0;
+};
+
+// Entities of one kind, packed into a dense vector for iteration with a slot per handle on the
+// side. Lookup, insertion and removal are O(1); removal moves the last entity into the gap, so the
+// iteration order changes but handles stay valid.
+//
+// Freed slots are reused oldest first, and only once MIN_FREE_SLOTS of them are waiting, so the
+// churn spreads over many slots instead of wearing through the generations of a single one.
+//
+// Handles can be allocated before the entity is inserted, for entities that need their handle
+// while they're still being set up (see Station).
+template <typename T>
+class SlotMap
+{
+public:
+    typedef ::Handle<T> Handle;
+
+    static const size_t MIN_FREE_SLOTS = 1024;
+
+    // A handle for a slot without an entity in it yet
+    Handle allocate()
+    {
+        uint32_t index;
+        if (m_FreeSlots.size() > MIN_FREE_SLOTS)
+        {
+            index = m_FreeSlots.front();
+            m_FreeSlots.pop_front();
+        }
+        else
+        {
+            if (m_Slots.size() >= Handle::MAX_INDEX)
+                throw std::runtime_error("SlotMap is full");
+
+            index = static_cast<uint32_t>(m_Slots.size());
+            m_Slots.push_back(Slot{});
+        }
+
+        m_Slots[index].allocated = true;
+        return Handle(index, m_Slots[index].generation);
+    }
+
+    // Puts an entity into the slot of an allocated handle
+    void insert(Handle handle, std::shared_ptr<T> value)
+    {
+        Slot *slot = findSlot(handle);
+        if (slot == nullptr || slot->denseIndex != NO_DENSE_INDEX)
+            throw std::runtime_error("SlotMap::insert with a stale or occupied handle");
+
+        slot->denseIndex = static_cast<uint32_t>(m_Values.size());
+        m_Values.push_back(std::move(value));
+        m_DenseSlots.push_back(handle.getIndex());
+    }
+
+    Handle insert(std::shared_ptr<T> value)
+    {
+        Handle handle = allocate();
+        insert(handle, std::move(value));
+        return handle;
+    }
+
+    // Removes the entity (if it was inserted) and frees the slot. Stale handles are ignored.
+    void remove(Handle handle)
+    {
+        Slot *slot = findSlot(handle);
+        if (slot == nullptr)
+            return;
+
+        if (slot->denseIndex != NO_DENSE_INDEX)
+        {
+            uint32_t denseIndex = slot->denseIndex;
+            uint32_t last = static_cast<uint32_t>(m_Values.size() - 1);
+            if (denseIndex != last)
+            {
+                m_Values[denseIndex] = std::move(m_Values[last]);
+                m_DenseSlots[denseIndex] = m_DenseSlots[last];
+                m_Slots[m_DenseSlots[denseIndex]].denseIndex = denseIndex;
+            }
+
+            m_Values.pop_back();
+            m_DenseSlots.pop_back();
+        }
+
+        slot->allocated = false;
+        slot->denseIndex = NO_DENSE_INDEX;
+        // skip 0 when wrapping around, that's the null handle's generation
+        slot->generation = slot->generation == Handle::MAX_GENERATION ? 1 : slot->generation + 1;
+        m_FreeSlots.push_back(handle.getIndex());
+    }
+
+    // Frees an allocated handle that never got an entity. Does nothing if the entity was inserted
+    // (remove is for those) or the handle is stale.
+    void release(Handle handle)
+    {
+        Slot *slot = findSlot(handle);
+        if (slot == nullptr || slot->denseIndex != NO_DENSE_INDEX)
+            return;
+
+        remove(handle);
+    }
+
+    // The entity, or nullptr if the handle is stale or nothing was inserted yet
+    const std::shared_ptr<T> *get(Handle handle) const
+    {
+        const Slot *slot = findSlot(handle);
+        if (slot == nullptr || slot->denseIndex == NO_DENSE_INDEX)
+            return nullptr;
+
+        return &m_Values[slot->denseIndex];
+    }
+
+    bool contains(Handle handle) const
+    {
+        return get(handle) != nullptr;
+    }
+
+    const std::vector<std::shared_ptr<T>> &values() const
+    {
+        return m_Values;
+    }
+
+    size_t size() const
+    {
+        return m_Values.size();
+    }
+
+    // One past the highest slot index handed out so far, for data kept per slot on the side
+    size_t slotCount() const
+    {
+        return m_Slots.size();
+    }
+
+private:
+    static const uint32_t NO_DENSE_INDEX = UINT32_MAX;
+
+    struct Slot
+    {
+        uint32_t generation = 1;
+        uint32_t denseIndex = NO_DENSE_INDEX;
+        bool allocated = false;
+    };
+
+    Slot *findSlot(Handle handle)
+    {
+        return const_cast<Slot *>(static_cast<const SlotMap *>(this)->findSlot(handle));
+    }
+    const Slot *findSlot(Handle handle) const
+    {
+        uint32_t index = handle.getIndex();
+        if (handle.isNull() || index >= m_Slots.size())
+            return nullptr;
+
+        const Slot &slot = m_Slots[index];
+        if (!slot.allocated || slot.generation != handle.getGeneration())
+            return nullptr;
+
+        return &slot;
+    }
+
+    std::vector<Slot> m_Slots;
+    std::deque<uint32_t> m_FreeSlots;
+
+    std::vector<std::shared_ptr<T>> m_Values;
+    // slot index of every dense entry, to fix up the slot when an entry moves
+    std::vector<uint32_t> m_DenseSlots;
+};
+
+class Ship;
+class Station;
+
+typedef Handle<Ship> ShipHandle;
+typedef Handle<Station> StationHandle;
@@ -0,0 +1,216 @@
+#include "spatialGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+
+SpatialGrid::SpatialGrid(float cellSize) : m_CellSize(cellSize)
+{
+}
+
+int64_t SpatialGrid::cellCoordinate(float value) const
+{
+    return static_cast<int64_t>(std::floor(value / m_CellSize));
+}
+
+uint64_t SpatialGrid::cellKey(int64_t x, int64_t y)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+}
+
+const std::vector<SpatialGrid::Entry> *SpatialGrid::getCell(int64_t x, int64_t y) const
+{
+    auto it = m_Cells.find(cellKey(x, y));
+    if (it == m_Cells.end() || it->second.empty())
+    {
+        return nullptr;
+    }
+
+    return &it->second;
+}
+
+void SpatialGrid::insert(int id, vec2f position, Station *station)
+{
+    int64_t x = cellCoordinate(position.x);
+    int64_t y = cellCoordinate(position.y);
+
+    m_Cells[cellKey(x, y)].push_back({id, position, station});
+    m_Size++;
+
+    if (m_MinCellX > m_MaxCellX)
+    {
+        m_MinCellX = m_MaxCellX = x;
+        m_MinCellY = m_MaxCellY = y;
+        return;
+    }
+
+    m_MinCellX = std::min(m_MinCellX, x);
+    m_MaxCellX = std::max(m_MaxCellX, x);
+    m_MinCellY = std::min(m_MinCellY, y);
+    m_MaxCellY = std::max(m_MaxCellY, y);
+}
+
+void SpatialGrid::remove(int id, vec2f position)
+{
+    auto it = m_Cells.find(cellKey(cellCoordinate(position.x), cellCoordinate(position.y)));
+    if (it == m_Cells.end())
+    {
+        throw std::runtime_error("Entry not found in grid");
+    }
+
+    auto &cell = it->second;
+    for (size_t i = 0; i < cell.size(); i++)
+    {
+        if (cell[i].id == id)
+        {
+            cell[i] = cell.back();
+            cell.pop_back();
+            m_Size--;
+            return;
+        }
+    }
+
+    throw std::runtime_error("Entry not found in grid");
+}
+
+void SpatialGrid::queryRadius(vec2f position, float radius, std::vector<Entry> &result) const
+{
+    if (m_Size == 0)
+        return;
+
+    int64_t minX = std::max(cellCoordinate(position.x - radius), m_MinCellX);
+    int64_t maxX = std::min(cellCoordinate(position.x + radius), m_MaxCellX);
+    int64_t minY = std::max(cellCoordinate(position.y - radius), m_MinCellY);
+    int64_t maxY = std::min(cellCoordinate(position.y + radius), m_MaxCellY);
+
+    float radius2 = radius * radius;
+
+    for (int64_t x = minX; x <= maxX; x++)
+    {
+        for (int64_t y = minY; y <= maxY; y++)
+        {
+            const std::vector<Entry> *cell = getCell(x, y);
+            if (!cell)
+                continue;
+
+            for (auto &entry : *cell)
+            {
+                float deltaX = entry.position.x - position.x;
+                float deltaY = entry.position.y - position.y;
+
+                if (deltaX * deltaX + deltaY * deltaY <= radius2)
+                {
+                    result.push_back(entry);
+                }
+            }
+        }
+    }
+}
+
+SpatialGrid::NearestIterator::NearestIterator(const SpatialGrid &grid, vec2f position, float maxDistance)
+    : m_Grid(grid), m_Position(position), m_MaxDistance2(maxDistance * maxDistance)
+{
+    m_CellX = grid.cellCoordinate(position.x);
+    m_CellY = grid.cellCoordinate(position.y);
+
+    float cellMinX = m_CellX * grid.m_CellSize;
+    float cellMinY = m_CellY * grid.m_CellSize;
+    m_DistanceToCellEdge = std::min({position.x - cellMinX, cellMinX + grid.m_CellSize - position.x,
+                                     position.y - cellMinY, cellMinY + grid.m_CellSize - position.y});
+    m_DistanceToCellEdge = std::max(m_DistanceToCellEdge, 0.0f);
+
+    if (grid.m_Size == 0)
+    {
+        m_LastRing = -1;
+        return;
+    }
+
+    // the ring that reaches the furthest occupied cell
+    m_LastRing = static_cast<int>(std::max({std::abs(m_CellX - grid.m_MinCellX), std::abs(grid.m_MaxCellX - m_CellX),
+                                            std::abs(m_CellY - grid.m_MinCellY), std::abs(grid.m_MaxCellY - m_CellY)}));
+
+    if (maxDistance != std::numeric_limits<float>::infinity())
+    {
+        int maxRing = static_cast<int>(std::ceil(maxDistance / grid.m_CellSize)) + 1;
+        m_LastRing = std::min(m_LastRing, maxRing);
+    }
+}
+
+float SpatialGrid::NearestIterator::ringLowerBound(int ring) const
+{
+    if (ring == 0)
+        return 0;
+
+    return (ring - 1) * m_Grid.m_CellSize + m_DistanceToCellEdge;
+}
+
+void SpatialGrid::NearestIterator::visitRing(int ring)
+{
+    auto visitCell = [&](int64_t x, int64_t y)
+    {
+        const std::vector<Entry> *cell = m_Grid.getCell(x, y);
+        if (!cell)
+            return;
+
+        for (auto &entry : *cell)
+        {
+            float deltaX = entry.position.x - m_Position.x;
+            float deltaY = entry.position.y - m_Position.y;
+            float distance2 = deltaX * deltaX + deltaY * deltaY;
+
+            if (distance2 > m_MaxDistance2)
+                continue;
+
+            m_Candidates.push_back({distance2, &entry});
+            std::push_heap(m_Candidates.begin(), m_Candidates.end(), std::greater<Candidate>());
+        }
+    };
+
+    if (ring == 0)
+    {
+        visitCell(m_CellX, m_CellY);
+        return;
+    }
+
+    // top and bottom rows, then the left and right columns without the corners
+    for (int64_t x = m_CellX - ring; x <= m_CellX + ring; x++)
+    {
+        visitCell(x, m_CellY - ring);
+        visitCell(x, m_CellY + ring);
+    }
+
+    for (int64_t y = m_CellY - ring + 1; y <= m_CellY + ring - 1; y++)
+    {
+        visitCell(m_CellX - ring, y);
+        visitCell(m_CellX + ring, y);
+    }
+}
+
+const SpatialGrid::Entry *SpatialGrid::NearestIterator::next()
+{
+    while (true)
+    {
+        // the nearest candidate is final once no unvisited ring can hold anything closer
+        if (!m_Candidates.empty())
+        {
+            float bound = m_NextRing > m_LastRing ? std::numeric_limits<float>::infinity() : ringLowerBound(m_NextRing);
+
+            if (m_Candidates.front().distance2 <= bound * bound)
+            {
+                std::pop_heap(m_Candidates.begin(), m_Candidates.end(), std::greater<Candidate>());
+                const Entry *entry = m_Candidates.back().entry;
+                m_Candidates.pop_back();
+                return entry;
+            }
+        }
+
+        if (m_NextRing > m_LastRing)
+        {
+            return nullptr;
+        }
+
+        visitRing(m_NextRing);
+        m_NextRing++;
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "vec.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+class Station;
+
+// Cell size (in world units) of the station grid. The game places roughly one station per 1100x1100
+// units, so a nearest-first search usually finds its first candidates in the ship's own cell.
+#define STATION_GRID_CELL_SIZE 2000.0f
+
+// Uniform grid over the stations, so a ship looking for a trade only has to look at the stations
+// around it instead of sorting every station in the world by distance. Cells are hashed, so the
+// world doesn't need bounds. Stations don't move; EntityManager keeps the grid in sync when
+// stations are added or removed.
+class SpatialGrid
+{
+public:
+    struct Entry
+    {
+        int id;
+        vec2f position;
+        // non-owning, the EntityManager owns the station
+        Station *station;
+    };
+
+    explicit SpatialGrid(float cellSize);
+
+    void insert(int id, vec2f position, Station *station);
+    void remove(int id, vec2f position);
+
+    size_t size() const
+    {
+        return m_Size;
+    }
+
+    // Appends every entry within radius of position to result, in no particular order
+    void queryRadius(vec2f position, float radius, std::vector<Entry> &result) const;
+
+    // Iterates the entries ordered by distance to a position, nearest first. Only visits the cells
+    // it needs to, so stopping early is cheap. The grid must not be changed while iterating.
+    class NearestIterator
+    {
+    public:
+        NearestIterator(const SpatialGrid &grid, vec2f position, float maxDistance);
+
+        // Next nearest entry, or nullptr once all entries within maxDistance have been returned
+        const Entry *next();
+
+    private:
+        struct Candidate
+        {
+            float distance2;
+            const Entry *entry;
+
+            bool operator>(const Candidate &other) const
+            {
+                return distance2 > other.distance2;
+            }
+        };
+
+        void visitRing(int ring);
+        // lower bound on the distance to any entry in a ring that hasn't been visited yet
+        float ringLowerBound(int ring) const;
+
+        const SpatialGrid &m_Grid;
+        vec2f m_Position;
+        float m_MaxDistance2;
+
+        int64_t m_CellX, m_CellY;
+        float m_DistanceToCellEdge;
+
+        int m_NextRing = 0;
+        int m_LastRing;
+
+        // min heap on distance
+        std::vector<Candidate> m_Candidates;
+    };
+
+    NearestIterator nearest(vec2f position, float maxDistance = std::numeric_limits<float>::infinity()) const
+    {
+        return NearestIterator(*this, position, maxDistance);
+    }
+
+private:
+    int64_t cellCoordinate(float value) const;
+    static uint64_t cellKey(int64_t x, int64_t y);
+    const std::vector<Entry> *getCell(int64_t x, int64_t y) const;
+
+    float m_CellSize;
+    size_t m_Size = 0;
+
+    std::unordered_map<uint64_t, std::vector<Entry>> m_Cells;
+
+    // bounds of the cells that ever held an entry, searches stop expanding past them
+    int64_t m_MinCellX = 0, m_MaxCellX = -1;
+    int64_t m_MinCellY = 0, m_MaxCellY = -1;
+};
@@ -1,81 +1,114 @@
 #include "station.hpp"
 #include "config.hpp"
 #include "ui.hpp"
+#include "metrics.hpp"
+#include "entityManager.hpp"
 
 #include "SDL2/SDL_image.h"
 #include "SDL2/SDL_ttf.h"
 
+#include <algorithm>
 #include <iostream>
 #include <cassert>
 #include <set>
 
-Station::Station(vec2f position, std::string_view name, std::shared_ptr<EntityManager> entityManager, std::shared_ptr<UI> ui, SDL_Renderer *renderer, TTF_Font *font) : m_Position(position), name(name), m_Renderer(renderer), m_Manager(entityManager), m_UI(ui)
+Station::Station(vec2f position, std::string_view name, std::shared_ptr<EntityManager> entityManager, std::shared_ptr<UI> ui, SDL_Renderer *renderer, TTF_Font *font) : name(name), m_Renderer(renderer), m_Manager(entityManager.get()), m_UI(ui)
 {
-    id = utils::generateId();
+    // before anything is allocated, the destructor doesn't run when the constructor throws
+    if (renderer && !font)
+    {
+        throw std::runtime_error("Failed to load font");
+    }
 
-    m_Texture = IMG_LoadTexture(renderer, "assets/station.png");
+    m_Handle = entityManager->allocateStationHandle();
+    id = entityManager->generateId();
 
-    if (!font)
+    m_Components = &entityManager->getStationComponents();
+    m_ComponentIndex = m_Components->add(this, position);
+
+    // headless simulation, there is nothing to draw
+    if (!renderer)
     {
-        throw std::runtime_error("Failed to load font");
+        return;
     }
 
+    StationRenderData &renderData = this->renderData();
+    renderData.texture = IMG_LoadTexture(renderer, "assets/station.png");
+
     SDL_Surface *nameSurface = TTF_RenderText_Blended(font, name.data(), {255, 255, 255});
-    m_NameTexture = SDL_CreateTextureFromSurface(renderer, nameSurface);
-    m_NameTextWidth = nameSurface->w;
-    m_NameTextHeight = nameSurface->h;
+    renderData.nameTexture = SDL_CreateTextureFromSurface(renderer, nameSurface);
+    renderData.nameTextWidth = nameSurface->w;
+    renderData.nameTextHeight = nameSurface->h;
     SDL_FreeSurface(nameSurface);
 }
 
 Station::~Station()
 {
-    SDL_DestroyTexture(m_Texture);
-    SDL_DestroyTexture(m_NameTexture);
+    StationRenderData &renderData = this->renderData();
+    if (renderData.texture)
+        SDL_DestroyTexture(renderData.texture);
+    if (renderData.nameTexture)
+        SDL_DestroyTexture(renderData.nameTexture);
+
+    m_Components->remove(m_ComponentIndex);
+
+    // only frees the slot if the station was never passed to addStation
+    m_Manager->releaseStationHandle(m_Handle);
 }
 
-void Station::addShip(std::shared_ptr<Ship> ship)
+void Station::scheduleTimer(float seconds, uint32_t id)
 {
-    ship->claim(shared_from_this());
-    owned_ships.push_back(std::move(ship));
-    printf("Ship added to station %d with ID=%d, current fleet size %d.\n", id, owned_ships.back()->getId(), owned_ships.size());
+    m_Manager->getTimers().schedule(seconds, timers::StationTimer{m_Handle, id});
 }
 
-void Station::removeShip(int ship_id)
+void Station::addShip(Ship &ship)
 {
-    for (int i = 0; i < owned_ships.size(); i++)
+    if (ship.getHandle().isNull())
     {
+        throw std::runtime_error("Ship has to be added to the EntityManager first");
+    }
 
-        if (owned_ships[i]->getId() == ship_id)
-        {
-            owned_ships.erase(owned_ships.begin() + i);
-            return;
-        }
+    ship.claim(m_Handle);
+    owned_ships.push_back(ship.getHandle());
+}
+
+void Station::removeShip(ShipHandle ship)
+{
+    auto it = std::find(owned_ships.begin(), owned_ships.end(), ship);
+    if (it == owned_ships.end())
+    {
+        throw std::runtime_error("Ship not found");
     }
 
-    throw std::runtime_error("Ship not found");
+    // the order of the owned ships doesn't matter
+    *it = owned_ships.back();
+    owned_ships.pop_back();
 }
 
 void Station::updateInventory(Ware ware, int quantity)
 {
-    if (inventory.find(ware) == inventory.end())
+    StationMarket &market = this->market();
+
+    if (market.inventory.find(ware) == market.inventory.end())
     {
-        inventory[ware] = 0;
+        market.inventory[ware] = 0;
     }
-    inventory[ware] += quantity;
+    market.inventory[ware] += quantity;
 
-    assert(inventory[ware] >= 0);
+    assert(market.inventory[ware] >= 0);
 
+    this->markDirty(ware);
     this->postUpdateInventory();
     this->reevaluateTradeOffers();
 
-    this->updateUI();
+    this->m_UIDirty = true;
 }
 
 void Station::__debug_print_inventory() const
 {
     std::cout << "===========================================\n";
     std::cout << "Inventory for station " << id << "\n\n";
-    for (auto &item : inventory)
+    for (auto &item : market().inventory)
     {
         auto details = wares::wareDetails.at(item.first);
         std::cout << "Ware: " << details.name << "; Quantity: " << item.second << "\n";
@@ -83,198 +116,266 @@ void Station::__debug_print_inventory() const
     std::cout << "\n===========================================" << std::endl;
 }
 
-void Station::updateTradeOffer(wares::TradeType type, Ware ware, int quantity, float priceChangePercentage)
+void Station::updateTradeOffer(wares::TradeType type, Ware ware, int quantity)
 {
-    bool hasSellOffer = this->sellOffers.find(ware) != this->sellOffers.end();
-    bool hasBuyOffer = this->buyOffers.find(ware) != this->buyOffers.end();
+    StationMarket &market = this->market();
+
+    bool hasSellOffer = market.sellOffers.find(ware) != market.sellOffers.end();
+    bool hasBuyOffer = market.buyOffers.find(ware) != market.buyOffers.end();
 
     if (quantity == 0)
     {
         if (hasSellOffer)
         {
-            sellOffers[ware] = {sellOffers[ware].price, 0};
+            market.sellOffers[ware] = {market.sellOffers[ware].price, 0};
         }
         else if (hasBuyOffer)
         {
-            buyOffers[ware] = {buyOffers[ware].price, 0};
+            market.buyOffers[ware] = {market.buyOffers[ware].price, 0};
         }
 
+        publishTradeOffers(ware);
         return;
     }
 
-    float max_min_ware_price = wares::wareDetails.at(ware).max_price - wares::wareDetails.at(ware).min_price;
+    // new offers start at the price least favourable to the other side, after that prices only move in
+    // StationComponents::updatePrices
+    const wares::WareDetails &details = wares::wareDetails.at(ware);
 
     if (type == wares::TradeType::Sell)
     {
-        float price;
+        float price = hasSellOffer ? market.sellOffers[ware].price : details.max_price;
 
-        if (hasSellOffer)
-        {
-            price = this->sellOffers[ware].price + max_min_ware_price * (priceChangePercentage + 0.00001);
-        }
-        else
-        {
-            price = wares::wareDetails.at(ware).max_price;
-        }
+        price = std::min(price, details.max_price);
+        price = std::max(price, details.min_price);
 
-        price = std::min(price, wares::wareDetails.at(ware).max_price);
-        price = std::max(price, wares::wareDetails.at(ware).min_price);
-
-        sellOffers[ware] = {price, quantity};
-        buyOffers.erase(ware);
+        market.sellOffers[ware] = {price, quantity};
+        market.buyOffers.erase(ware);
 
+        publishTradeOffers(ware);
         return;
     }
 
-    float price;
+    float price = hasBuyOffer ? market.buyOffers[ware].price : details.min_price;
 
-    if (hasBuyOffer)
-    {
-        price = this->buyOffers[ware].price + max_min_ware_price * (priceChangePercentage - 0.00001);
-    }
+    price = std::min(price, details.max_price);
+    price = std::max(price, details.min_price);
+
+    market.buyOffers[ware] = {price, quantity};
+    market.sellOffers.erase(ware);
+
+    publishTradeOffers(ware);
+}
+
+void Station::publishTradeOffers(Ware ware)
+{
+    StationMarket &market = this->market();
+
+    uint32_t bit = 1u << static_cast<uint32_t>(ware);
+    market.openSellOffers = market.sellOffers.contains(ware) && market.sellOffers.get(ware).quantity > 0 ? market.openSellOffers | bit : market.openSellOffers & ~bit;
+    market.openBuyOffers = market.buyOffers.contains(ware) && market.buyOffers.get(ware).quantity > 0 ? market.openBuyOffers | bit : market.openBuyOffers & ~bit;
+
+    if (market.openSellOffers & bit)
+        m_Components->setOpenOffer(m_ComponentIndex, ware, 1.0f, market.sellOffers.get(ware).price);
+    else if (market.openBuyOffers & bit)
+        m_Components->setOpenOffer(m_ComponentIndex, ware, -1.0f, market.buyOffers.get(ware).price);
     else
-    {
-        price = wares::wareDetails.at(ware).min_price;
-    }
+        m_Components->setOpenOffer(m_ComponentIndex, ware, 0.0f, 0.0f);
+
+    auto &book = m_Manager->getOrderBook()[ware];
 
-    price = std::min(price, wares::wareDetails.at(ware).max_price);
-    price = std::max(price, wares::wareDetails.at(ware).min_price);
+    auto sellOffer = market.sellOffers.find(ware);
+    if (sellOffer != market.sellOffers.end())
+        book.setOffer(wares::TradeType::Sell, id, this, sellOffer->second.price, sellOffer->second.quantity);
+    else
+        book.removeOffer(wares::TradeType::Sell, id);
 
-    buyOffers[ware] = {price, quantity};
-    sellOffers.erase(ware);
+    auto buyOffer = market.buyOffers.find(ware);
+    if (buyOffer != market.buyOffers.end())
+        book.setOffer(wares::TradeType::Buy, id, this, buyOffer->second.price, buyOffer->second.quantity);
+    else
+        book.removeOffer(wares::TradeType::Buy, id);
 }
 
 // Transfers wares between the station and a ship. The quantity should be positive if the ship is buying,
 // and negative if the ship is selling. Throws an exception if the trade is invalid (e.g. not enough inventory to sell).
-void Station::transferWares(std::shared_ptr<Ship> ship, Ware ware, int quantity)
+void Station::transferWares(Ship &ship, Ware ware, int quantity)
 {
-    if (sellReservations[ware] < quantity)
+    StationMarket &market = this->market();
+
+    if (market.sellReservations[ware] < quantity)
     {
         throw std::runtime_error("Not enough inventory to transfer");
     }
 
-    if (ship->getCargoSpace() < quantity)
+    if (ship.getCargoSpace() < quantity)
     {
         throw std::runtime_error("Not enough cargo space to transfer");
     }
 
     if (quantity < 0)
     {
-        buyReservations[ware] -= -quantity;
+        market.buyReservations[ware] -= -quantity;
         this->updateInventory(ware, -quantity);
     }
     else
     {
-        sellReservations[ware] += quantity;
+        market.sellReservations[ware] += quantity;
     }
+    this->markDirty(ware);
 
-    ship->addWare(ware, quantity);
+    ship.addWare(ware, quantity);
     this->reevaluateTradeOffers();
+
+    metrics::waresTransferred.add(quantity < 0 ? -quantity : quantity);
 }
 
-void Station::requestDock(std::shared_ptr<Ship> ship)
+void Station::requestDock(Ship &ship)
 {
-    if (docked_ships.size() < m_max_docked_ships)
+    uint32_t slot = m_Dock.request(ship.getHandle(), m_Manager->getTick());
+    if (slot != DockingBay::NO_SLOT)
     {
-        docked_ships.push_back(ship);
-        ship->dock(shared_from_this());
+        metrics::shipsDocked.add();
+        ship.dock(*this, slot);
         return;
     }
 
-    dock_queue.push_back(ship);
+    metrics::shipsQueued.add();
 }
 
-void Station::undock(std::shared_ptr<Ship> ship)
+void Station::undock(Ship &ship)
 {
+    m_Dock.release(ship.getDockSlot(), ship.getHandle());
+    admitWaitingShips();
+}
+
+void Station::admitWaitingShips()
+{
+    // a docked ship runs its next orders right away, which usually undocks it again and ends up
+    // back here. The loop below hands out that slot as well, so this doesn't recurse.
+    if (m_AdmittingShips)
+        return;
+
+    m_AdmittingShips = true;
 
-    for (int i = 0; i < docked_ships.size(); i++)
+    ShipHandle handle;
+    uint32_t slot;
+    uint64_t waitedTicks;
+    while (m_Dock.admitNext(m_Manager->getTick(), handle, slot, waitedTicks))
     {
-        if (docked_ships[i]->getId() == ship->getId())
+        Ship *ship = m_Manager->getShip(handle);
+        if (ship == nullptr)
         {
-            docked_ships.erase(docked_ships.begin() + i);
-            return;
+            // removed while it was waiting
+            m_Dock.release(slot, handle);
+            continue;
         }
+
+        metrics::shipsDocked.add();
+        metrics::shipsAdmittedFromQueue.add();
+        metrics::dockWaitTicks.add(static_cast<int64_t>(waitedTicks));
+        ship->dock(*this, slot);
     }
 
-    throw std::runtime_error("Ship not found");
+    m_AdmittingShips = false;
 }
 
-// Reevaluates the trade offers for the station based on the current inventory levels
-// and the reservations made by ships.
+int Station::getMaintenanceLevelDiff(Ware ware) const
+{
+    const StationMarket &market = this->market();
+
+    int level = market.inventory.get(ware) + market.buyReservations.get(ware);
+    return level - market.maintenanceLevels.at(ware);
+}
+
+// Reevaluates the trade offers for the wares whose inventory levels or reservations changed
+// since the last evaluation. Only the type and quantity of an offer change here, prices move
+// with time in StationComponents::updatePrices.
 void Station::reevaluateTradeOffers()
 {
-    for (auto const &[ware, inventoryLevel] : inventory)
+    StationMarket &market = this->market();
+
+    for (size_t i = 0; i < wares::WARE_COUNT && market.dirtyWares != 0; i++)
     {
-        if (maintenanceLevels.find(ware) == maintenanceLevels.end())
-        {
-            // warning
-            // std::cerr << "Warning: Maintenance level for ware " << wares::wareDetails.at(ware).name << " has not been set.\n";
+        uint32_t bit = 1u << i;
+        if ((market.dirtyWares & bit) == 0)
             continue;
-        }
-        int level = inventoryLevel + buyReservations[ware];
-        int maintenanceLevelDiff = level - maintenanceLevels.at(ware);
+
+        market.dirtyWares &= ~bit;
+
+        Ware ware = static_cast<Ware>(i);
+        if (market.maintenanceLevels.find(ware) == market.maintenanceLevels.end())
+            continue;
+
+        int maintenanceLevelDiff = getMaintenanceLevelDiff(ware);
+        m_Components->setLevelDiff(m_ComponentIndex, ware, maintenanceLevelDiff);
+
         wares::TradeType type = maintenanceLevelDiff >= 0 ? wares::TradeType::Sell : wares::TradeType::Buy;
         int quantity = maintenanceLevelDiff > 0 ? maintenanceLevelDiff : -maintenanceLevelDiff;
-        // if (quantity == 0)
-        // continue;
-        // price change HIER!!! maintenance levels kunnen ook 0 zijn slimpie, dus division by zero
-        // float b = maintenanceLevelDiff > 0 ? maintenanceLevelDiff : 1000 - maintenanceLevelDiff;
-        // float a = MAX_ALLOWED_PRICE_CHANGE_PERCENTAGE / pow(maintenanceLevelDiff, PRICE_CHANGE_EXPONENT);
-        // float a = MAX_ALLOWED_PRICE_CHANGE_PERCENTAGE / pow(1000, PRICE_CHANGE_EXPONENT);
-        // float priceChangePercentage = a * pow(maintenanceLevelDiff, PRICE_CHANGE_EXPONENT);
-        float a = MAX_ALLOWED_PRICE_CHANGE_PERCENTAGE / pow(MAX_EXPECTED_PRODUCT_COUNT, PRICE_CHANGE_EXPONENT);
-        float priceChangePercentage = a * pow(-maintenanceLevelDiff, PRICE_CHANGE_EXPONENT);
-        priceChangePercentage = std::min(priceChangePercentage, static_cast<float>(MAX_ALLOWED_PRICE_CHANGE_PERCENTAGE));
-        updateTradeOffer(type, ware, quantity, priceChangePercentage);
-    };
+        updateTradeOffer(type, ware, quantity);
+    }
 }
 
 void Station::setMaintenanceLevel(Ware ware, int level)
 {
-    if (inventory.find(ware) == inventory.end())
+    StationMarket &market = this->market();
+
+    if (market.inventory.find(ware) == market.inventory.end())
     {
-        inventory[ware] = 0;
+        market.inventory[ware] = 0;
     }
-    maintenanceLevels[ware] = level;
+    market.maintenanceLevels[ware] = level;
+    markDirty(ware);
+    reevaluateTradeOffers();
 }
 // Accepts a trade offer for a specific ware, in this case, the TradeType should be of the offer
 // that's being accepted (i.e. if the client is buying, the TradeType should be Sell, and vice versa)
 // Throws an exception if the trade is invalid (e.g. not enough inventory to sell).
 void Station::acceptTrade(wares::TradeType type, Ware ware, int quantity)
 {
+    StationMarket &market = this->market();
+
     if (type == wares::TradeType::Sell)
     {
-        if (inventory[ware] < quantity)
+        if (market.inventory[ware] < quantity)
             throw std::runtime_error("Not enough inventory to sell");
-        if (sellReservations.find(ware) == sellReservations.end())
+        if (market.sellReservations.find(ware) == market.sellReservations.end())
         {
-            sellReservations[ware] = 0;
+            market.sellReservations[ware] = 0;
         }
-        sellReservations[ware] += quantity;
+        market.sellReservations[ware] += quantity;
         updateInventory(ware, -quantity);
     }
     else
     {
-        if (buyReservations.find(ware) == buyReservations.end())
+        if (market.buyReservations.find(ware) == market.buyReservations.end())
         {
-            buyReservations[ware] = 0;
+            market.buyReservations[ware] = 0;
         }
-        buyReservations[ware] += quantity;
+        market.buyReservations[ware] += quantity;
+        markDirty(ware);
     }
     reevaluateTradeOffers();
+
+    metrics::tradesAccepted.add();
 }
 
 void Station::updateUI()
 {
+    StationMarket &market = this->market();
+
+    this->m_UIDirty = false;
+
     if (!this->m_Selected)
         return;
 
     UISupport::DataDisplay dataDisplay;
 
     dataDisplay.push_back({"Station", name});
-    dataDisplay.push_back({"Position", std::to_string((int)m_Position.x) + ", " + std::to_string((int)m_Position.y)});
+    vec2f position = getPosition();
+    dataDisplay.push_back({"Position", std::to_string((int)position.x) + ", " + std::to_string((int)position.y)});
 
-    for (auto &item : inventory)
+    for (auto &item : market.inventory)
     {
         auto details = wares::wareDetails.at(item.first);
         if (details.name.empty())
@@ -283,7 +384,7 @@ void Station::updateUI()
         dataDisplay.push_back({details.name, std::to_string(item.second)});
     }
 
-    for (auto &item : sellOffers)
+    for (auto &item : market.sellOffers)
     {
         auto details = wares::wareDetails.at(item.first);
         if (details.name.empty())
@@ -293,7 +394,7 @@ void Station::updateUI()
         dataDisplay.push_back({details.name + " sell quantity", std::to_string(item.second.quantity)});
     }
 
-    for (auto &item : buyOffers)
+    for (auto &item : market.buyOffers)
     {
         auto details = wares::wareDetails.at(item.first);
         if (details.name.empty())
@@ -322,7 +423,9 @@ bool Station::checkForAndHandleMouseClick(vec2f camera, Sint32 x, Sint32 y)
     // this->m_Selected = false;
     // return false;
 
-    if (x >= m_OnScreenX && x <= m_OnScreenX + m_OnScreenWidth && y >= m_OnScreenY && y <= m_OnScreenY + m_OnScreenHeight)
+    const StationRenderData &renderData = this->renderData();
+
+    if (x >= renderData.onScreenX && x <= renderData.onScreenX + renderData.onScreenWidth && y >= renderData.onScreenY && y <= renderData.onScreenY + renderData.onScreenHeight)
     {
         this->m_Selected = !this->m_Selected;
         this->updateUI();
@@ -342,7 +445,14 @@ void Station::deselect()
 // SDL
 void Station::render(vec2f &camera, float &zoomLevel, vec2f &zoomCenter)
 {
-    vec2f position = m_Position - camera;
+    if (m_UIDirty)
+    {
+        this->updateUI();
+    }
+
+    StationRenderData &renderData = this->renderData();
+
+    vec2f position = getPosition() - camera;
 
     SDL_Rect dest;
 
@@ -351,23 +461,23 @@ void Station::render(vec2f &camera, float &zoomLevel, vec2f &zoomCenter)
     dest.w = 30 * zoomLevel;
     dest.h = 30 * zoomLevel;
 
-    m_OnScreenX = dest.x;
-    m_OnScreenY = dest.y;
-    m_OnScreenWidth = dest.w;
-    m_OnScreenHeight = dest.h;
+    renderData.onScreenX = dest.x;
+    renderData.onScreenY = dest.y;
+    renderData.onScreenWidth = dest.w;
+    renderData.onScreenHeight = dest.h;
 
-    SDL_RenderCopy(m_Renderer, m_Texture, NULL, &dest);
+    SDL_RenderCopy(m_Renderer, renderData.texture, NULL, &dest);
 
     if (zoomLevel < 0.5f)
         return;
 
     SDL_Rect nameDest;
-    nameDest.x = dest.x - m_NameTextWidth / 2;
+    nameDest.x = dest.x - renderData.nameTextWidth / 2;
     nameDest.y = dest.y - 30;
-    nameDest.w = m_NameTextWidth;
-    nameDest.h = m_NameTextHeight;
+    nameDest.w = renderData.nameTextWidth;
+    nameDest.h = renderData.nameTextHeight;
 
-    SDL_RenderCopy(m_Renderer, m_NameTexture, NULL, &nameDest);
+    SDL_RenderCopy(m_Renderer, renderData.nameTexture, NULL, &nameDest);
 
     if (m_Selected)
     {
@@ -1,9 +1,13 @@
 #pragma once
 
 #include "vec.hpp"
+#include "components.hpp"
 #include "utils.hpp"
 #include "wares.hpp"
 #include "ship.hpp"
+#include "slotMap.hpp"
+#include "commandBuffer.hpp"
+#include "docking.hpp"
 
 // SDL
 #include <SDL2/SDL.h>
@@ -11,7 +15,6 @@
 #include <SDL2/SDL_ttf.h>
 
 // std
-#include <map>
 #include <vector>
 #include <string>
 #include <memory>
@@ -30,20 +33,25 @@ public:
     Station(vec2f position, std::string_view name, std::shared_ptr<EntityManager> entityManager, std::shared_ptr<UI> ui, SDL_Renderer *renderer, TTF_Font *font);
     ~Station();
 
-    virtual void tick(float dt) = 0;
+    // Called when a timer the station scheduled (see scheduleTimer) fires, with the id it was
+    // scheduled with. Ships are spawned through the command buffer, it's applied after all timers of the tick.
+    virtual void onTimer(uint32_t id, CommandBuffer &commands) = 0;
 
-    void addShip(std::shared_ptr<Ship> ship);
-    void removeShip(int ship_id);
+    // The ship has to be in the EntityManager already, the station only keeps its handle
+    void addShip(Ship &ship);
+    void removeShip(ShipHandle ship);
 
     void acceptTrade(wares::TradeType type, Ware ware, int quantity);
 
     void setMaintenanceLevel(Ware ware, int level);
+    // Updates the offers for the wares whose stock changed since the last evaluation
     void reevaluateTradeOffers();
 
-    void transferWares(std::shared_ptr<Ship> ship, Ware ware, int quantity);
+    void transferWares(Ship &ship, Ware ware, int quantity);
 
-    void requestDock(std::shared_ptr<Ship> ship);
-    void undock(std::shared_ptr<Ship> ship);
+    // Docks the ship, or queues it until a slot frees up (then it docks from within undock)
+    void requestDock(Ship &ship);
+    void undock(Ship &ship);
 
     bool checkForAndHandleMouseClick(vec2f camera, Sint32 x, Sint32 y);
     void deselect();
@@ -53,19 +61,30 @@ public:
         return id;
     }
 
-    const std::map<Ware, wares::Offer> &getBuyOffers() const
+    StationHandle getHandle() const
     {
-        return buyOffers;
+        return m_Handle;
     }
 
-    const std::map<Ware, wares::Offer> &getSellOffers() const
+    const wares::WareArray<wares::Offer> &getBuyOffers() const
     {
-        return sellOffers;
+        return market().buyOffers;
     }
 
-    const vec2f &getPosition() const
+    const wares::WareArray<wares::Offer> &getSellOffers() const
     {
-        return m_Position;
+        return market().sellOffers;
+    }
+
+    wares::MarketOffers getMarketOffers() const
+    {
+        const StationMarket &market = this->market();
+        return {market.buyOffers, market.sellOffers, market.openBuyOffers, market.openSellOffers};
+    }
+
+    vec2f getPosition() const
+    {
+        return m_Components->getPosition(m_ComponentIndex);
     }
 
     const std::string &getName() const
@@ -73,48 +92,76 @@ public:
         return name;
     }
 
+    size_t getDockQueueSize() const
+    {
+        return m_Dock.getQueueLength();
+    }
+
+    size_t getDockedShipCount() const
+    {
+        return m_Dock.getDockedCount();
+    }
+
     void __debug_print_inventory() const;
 
 protected:
     virtual void postUpdateInventory() = 0;
 
+    StationHandle m_Handle;
+    // see EntityManager::generateId
     int id;
     std::string name;
 
     bool m_Selected = false;
+    // The UI is only touched from the main thread, so inventory changes just flag it for an update
+    bool m_UIDirty = false;
 
-    std::shared_ptr<EntityManager> m_Manager;
+    // never owned, the EntityManager owns the stations
+    EntityManager *m_Manager;
 
     float credits;
 
-    vec2f m_Position;
-
-    std::shared_ptr<EntityManager> entityManager;
     std::shared_ptr<UI> m_UI;
 
-    std::map<Ware, wares::Offer> sellOffers;
-    std::map<Ware, wares::Offer> buyOffers;
-
-    std::map<Ware, int> maintenanceLevels;
+    // offers, stock and render data live in the EntityManager's StationComponents, see StationMarket
+    StationComponents *m_Components;
+    size_t m_ComponentIndex;
 
-    std::map<Ware, int> inventory;
-    // Virtual inventory keeping track of the wares that the station is planning to buy
-    std::map<Ware, int> buyReservations;
-    // Virtual inventory keeping track of the wares that the station is planning to sell
-    std::map<Ware, int>
-        sellReservations;
+    StationMarket &market()
+    {
+        return m_Components->getMarket(m_ComponentIndex);
+    }
+    const StationMarket &market() const
+    {
+        return m_Components->getMarket(m_ComponentIndex);
+    }
+    StationRenderData &renderData()
+    {
+        return m_Components->getRenderData(m_ComponentIndex);
+    }
 
-    const int m_max_docked_ships = 5;
+    std::vector<ShipHandle> owned_ships;
 
-    std::vector<std::shared_ptr<Ship>> owned_ships;
-    std::vector<std::shared_ptr<Ship>> docked_ships;
+    DockingBay m_Dock;
+    // set while admitWaitingShips runs, ships it docks may undock again right away
+    bool m_AdmittingShips = false;
 
-    std::vector<std::shared_ptr<Ship>> dock_queue;
+    void admitWaitingShips();
 
-    void updateTradeOffer(wares::TradeType type, wares::Ware ware, int quantity, float priceChangePercentage);
+    void updateTradeOffer(wares::TradeType type, wares::Ware ware, int quantity);
+    void markDirty(Ware ware)
+    {
+        market().dirtyWares |= 1u << static_cast<uint32_t>(ware);
+    }
+    int getMaintenanceLevelDiff(Ware ware) const;
+    // Copies the current offers for a ware into the open offer masks, the pricing columns and the global order book
+    void publishTradeOffers(wares::Ware ware);
 
     void updateInventory(Ware ware, int quantity);
 
+    // Calls onTimer with the id after the given simulated time
+    void scheduleTimer(float seconds, uint32_t id);
+
     void updateUI();
 
     // SDL
@@ -123,10 +170,6 @@ public:
 
 protected:
     SDL_Renderer *m_Renderer;
-    SDL_Texture *m_Texture;
-    SDL_Texture *m_NameTexture;
-    int m_NameTextWidth, m_NameTextHeight;
 
-    int m_OnScreenX, m_OnScreenY;
-    int m_OnScreenWidth, m_OnScreenHeight;
+    friend class StationComponents;
 };
@@ -0,0 +1,92 @@
+#include "threadPool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threadCount)
+{
+    threadCount = std::max<size_t>(threadCount, 1);
+
+    m_Workers.reserve(threadCount - 1);
+    for (size_t i = 1; i < threadCount; i++)
+    {
+        m_Workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stopping = true;
+    }
+    m_WorkAvailable.notify_all();
+
+    for (auto &worker : m_Workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t, size_t, size_t)> &fn)
+{
+    if (m_Workers.empty() || count < 2)
+    {
+        fn(0, count, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Job = &fn;
+        m_JobCount = count;
+        m_PendingWorkers = m_Workers.size();
+        m_Generation++;
+    }
+    m_WorkAvailable.notify_all();
+
+    runChunk(0);
+
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_WorkDone.wait(lock, [this]
+                    { return m_PendingWorkers == 0; });
+    m_Job = nullptr;
+}
+
+void ThreadPool::workerLoop(size_t chunkIndex)
+{
+    size_t seenGeneration = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_WorkAvailable.wait(lock, [&]
+                                 { return m_Stopping || m_Generation != seenGeneration; });
+
+            if (m_Stopping)
+                return;
+
+            seenGeneration = m_Generation;
+        }
+
+        runChunk(chunkIndex);
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_PendingWorkers--;
+        }
+        m_WorkDone.notify_one();
+    }
+}
+
+void ThreadPool::runChunk(size_t chunkIndex)
+{
+    size_t chunks = getThreadCount();
+    size_t begin = m_JobCount * chunkIndex / chunks;
+    size_t end = m_JobCount * (chunkIndex + 1) / chunks;
+
+    if (begin < end)
+    {
+        (*m_Job)(begin, end, chunkIndex);
+    }
+}
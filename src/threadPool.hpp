@@ -0,0 +1,46 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads used to split per-tick work (e.g. ticking all stations).
+// The thread calling parallelFor takes part in the work, so a pool of size 1 runs everything inline.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(size_t threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Number of threads work is split over, including the calling thread.
+    size_t getThreadCount() const
+    {
+        return m_Workers.size() + 1;
+    }
+
+    // Splits [0, count) into getThreadCount() contiguous chunks and calls fn(begin, end, chunkIndex)
+    // once per chunk. Chunk boundaries only depend on count and the thread count, so results
+    // collected per chunk can be merged in a deterministic order. Blocks until all chunks are done.
+    void parallelFor(size_t count, const std::function<void(size_t, size_t, size_t)> &fn);
+
+private:
+    void workerLoop(size_t chunkIndex);
+    void runChunk(size_t chunkIndex);
+
+    std::vector<std::thread> m_Workers;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_WorkAvailable;
+    std::condition_variable m_WorkDone;
+
+    const std::function<void(size_t, size_t, size_t)> *m_Job = nullptr;
+    size_t m_JobCount = 0;
+    size_t m_Generation = 0;
+    size_t m_PendingWorkers = 0;
+    bool m_Stopping = false;
+};
@@ -0,0 +1,80 @@
+#include "timerWheel.hpp"
+
+#include <cmath>
+#include <utility>
+
+void TimerWheel::schedule(float seconds, TimerEvent event)
+{
+    long long ticks = std::llround(seconds / m_TickLength);
+    scheduleTicks(ticks > 0 ? static_cast<uint64_t>(ticks) : 1, std::move(event));
+}
+
+void TimerWheel::scheduleTicks(uint64_t ticks, TimerEvent event)
+{
+    // the current tick already fired
+    if (ticks == 0)
+        ticks = 1;
+
+    place(Timer{m_Tick + ticks, std::move(event)});
+    m_Size++;
+}
+
+void TimerWheel::place(Timer timer)
+{
+    // the lowest level whose current span (the slots not passed yet) contains the due tick
+    for (uint32_t level = 0; level < LEVELS; level++)
+    {
+        uint32_t spanShift = SLOT_BITS * (level + 1);
+        if ((timer.due >> spanShift) != (m_Tick >> spanShift))
+            continue;
+
+        uint32_t slot = static_cast<uint32_t>(timer.due >> (SLOT_BITS * level)) & (SLOTS - 1);
+        m_Slots[level][slot].push_back(std::move(timer));
+        return;
+    }
+
+    m_Overflow.push_back(std::move(timer));
+}
+
+void TimerWheel::cascade(std::vector<Timer> &timers)
+{
+    // placing only ever moves timers to lower levels (or back into the overflow list), so they
+    // can't end up in the vector being emptied here
+    m_Cascading.swap(timers);
+    for (auto &timer : m_Cascading)
+    {
+        place(std::move(timer));
+    }
+    m_Cascading.clear();
+}
+
+void TimerWheel::advance(std::vector<TimerEvent> &fired)
+{
+    m_Tick++;
+
+    // the whole wheel went around, the overflow list may have timers for the new span
+    if ((m_Tick & ((uint64_t(1) << (SLOT_BITS * LEVELS)) - 1)) == 0)
+    {
+        cascade(m_Overflow);
+    }
+
+    // reaching the start of a slot on a higher level moves its timers down, highest level first,
+    // so timers can move down more than one level at once
+    for (uint32_t level = LEVELS - 1; level > 0; level--)
+    {
+        uint32_t shift = SLOT_BITS * level;
+        if ((m_Tick & ((uint64_t(1) << shift) - 1)) != 0)
+            continue;
+
+        cascade(m_Slots[level][(m_Tick >> shift) & (SLOTS - 1)]);
+    }
+
+    auto &due = m_Slots[0][m_Tick & (SLOTS - 1)];
+    for (auto &timer : due)
+    {
+        fired.push_back(std::move(timer.event));
+    }
+
+    m_Size -= due.size();
+    due.clear();
+}
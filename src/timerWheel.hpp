@@ -0,0 +1,99 @@
+#pragma once
+
+#include "config.hpp"
+#include "slotMap.hpp"
+
+#include <cstdint>
+#include <variant>
+#include <vector>
+
+// Things that happen after a delay in simulated time, see TimerWheel. Timers can't be cancelled,
+// the handles just stop resolving once their entity is removed.
+namespace timers
+{
+
+    // Handed back to the station through Station::onTimer, the id tells the station what it was for
+    struct StationTimer
+    {
+        StationHandle station;
+        uint32_t id;
+    };
+
+    // The ship looks for a trade, see Ship::searchForTrade
+    struct TradeCheck
+    {
+        ShipHandle ship;
+    };
+
+    // See shipPurchaseCheck
+    struct ShipPurchaseCheck
+    {
+    };
+
+}
+
+typedef std::variant<timers::StationTimer, timers::TradeCheck, timers::ShipPurchaseCheck> TimerEvent;
+
+// Hierarchical timer wheel over simulation ticks. Each level has 64 slots, a slot on level n
+// spanning 64^n ticks. Timers go into the lowest level whose current span they fall into and move
+// down a level whenever the wheel reaches their slot, so scheduling is O(1) and a tick only
+// touches the timers that are due (plus the ones moving down). Timers further out than the top
+// level (about 77 hours of simulated time) wait in an overflow list.
+//
+// Only touched from the main thread, timers are scheduled and fired serially.
+class TimerWheel
+{
+public:
+    static const uint32_t LEVELS = 4;
+    static const uint32_t SLOT_BITS = 6;
+    static const uint32_t SLOTS = 1u << SLOT_BITS;
+
+    // Fires after the given simulated time, rounded to whole ticks (at least one)
+    void schedule(float seconds, TimerEvent event);
+    void scheduleTicks(uint64_t ticks, TimerEvent event);
+
+    // Moves on to the next tick and appends the events due then to fired, in the order they were scheduled
+    void advance(std::vector<TimerEvent> &fired);
+
+    // Simulated seconds between two calls to advance, SIM_TIMESTEP unless the simulation is
+    // stepped with a different dt. Only affects timers scheduled afterwards.
+    void setTickLength(float seconds)
+    {
+        m_TickLength = seconds;
+    }
+    float getTickLength() const
+    {
+        return m_TickLength;
+    }
+
+    // Number of times advance was called
+    uint64_t getTick() const
+    {
+        return m_Tick;
+    }
+
+    // Number of timers that haven't fired yet
+    size_t size() const
+    {
+        return m_Size;
+    }
+
+private:
+    struct Timer
+    {
+        uint64_t due;
+        TimerEvent event;
+    };
+
+    void place(Timer timer);
+    void cascade(std::vector<Timer> &timers);
+
+    std::vector<Timer> m_Slots[LEVELS][SLOTS];
+    std::vector<Timer> m_Overflow;
+    // reused by cascade
+    std::vector<Timer> m_Cascading;
+
+    uint64_t m_Tick = 0;
+    size_t m_Size = 0;
+    float m_TickLength = SIM_TIMESTEP;
+};
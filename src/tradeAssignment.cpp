@@ -0,0 +1,247 @@
+#include "tradeAssignment.hpp"
+#include "entityManager.hpp"
+#include "ship.hpp"
+#include "station.hpp"
+#include "threadPool.hpp"
+#include "profiler.hpp"
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void TradeAssigner::buildOfferGrid(const EntityManager &entityManager, wares::Ware ware, wares::TradeType type, OfferGrid &offers) const
+{
+    std::vector<WareOrderBook::Entry> entries;
+    entityManager.getOrderBook()[ware].getOffers(type, entries);
+
+    // about as many offers per cell as the station grid has stations, so sparse offers don't
+    // leave the searches walking rings of empty cells
+    size_t stationCount = std::max<size_t>(entityManager.getStations().size(), 1);
+    float density = static_cast<float>(stationCount) / static_cast<float>(std::max<size_t>(entries.size(), 1));
+    offers.grid = SpatialGrid(STATION_GRID_CELL_SIZE * std::sqrt(std::max(density, 1.0f)));
+    offers.bestPrice.reset();
+
+    for (auto &entry : entries)
+    {
+        offers.grid.insert(entry.stationId, entry.station->getPosition(), entry.station);
+
+        // the lowest price sells best, the highest price buys best
+        bool better = !offers.bestPrice.has_value() ||
+                      (type == wares::TradeType::Sell ? entry.price < *offers.bestPrice : entry.price > *offers.bestPrice);
+        if (better)
+            offers.bestPrice = entry.price;
+    }
+}
+
+void TradeAssigner::collectCandidates(size_t shipIndex, std::vector<Candidate> &candidates) const
+{
+    const IdleShip &idle = m_IdleShips[shipIndex];
+    auto ownerOffers = idle.owner->getMarketOffers();
+
+    vec2f ownerPosition = idle.owner->getPosition();
+    vec2f shipPosition = idle.ship->getPosition();
+    int cargoCapacity = idle.ship->getCargoSpace();
+
+    for (uint32_t remaining = ownerOffers.openSellOffers | ownerOffers.openBuyOffers; remaining != 0; remaining &= remaining - 1)
+    {
+        auto ware = static_cast<wares::Ware>(wares::lowestBitIndex(remaining));
+        uint32_t bit = 1u << static_cast<uint32_t>(ware);
+        float maxPrice = wares::wareDetails.at(ware).max_price;
+
+        // same types as Ship::commitTrade: Buy means the ship buys from its owner and sells to the
+        // station, Sell means it buys from the station and sells to its owner
+        wares::TradeType type;
+        wares::Offer ownerOffer;
+        const OfferGrid *offers;
+
+        if ((ownerOffers.openSellOffers & bit) != 0)
+        {
+            type = wares::TradeType::Buy;
+            ownerOffer = ownerOffers.sellOffers.get(ware);
+            offers = &m_BuyOffers[static_cast<size_t>(ware)];
+
+            if (!offers->bestPrice.has_value() || *offers->bestPrice < ownerOffer.price)
+                continue;
+        }
+        else
+        {
+            type = wares::TradeType::Sell;
+            ownerOffer = ownerOffers.buyOffers.get(ware);
+            offers = &m_SellOffers[static_cast<size_t>(ware)];
+
+            if (!offers->bestPrice.has_value() || *offers->bestPrice > ownerOffer.price)
+                continue;
+        }
+
+        // trips always run between the owner and the station, so look for offers around the owner
+        auto nearestOffers = offers->grid.nearest(ownerPosition);
+        size_t visited = 0;
+        size_t found = 0;
+
+        while (found < TRADE_ASSIGNMENT_CANDIDATES && visited < TRADE_ASSIGNMENT_SEARCH_LIMIT)
+        {
+            const SpatialGrid::Entry *entry = nearestOffers.next();
+            if (entry == nullptr)
+                break;
+
+            visited++;
+
+            if (entry->station == idle.owner)
+                continue;
+
+            // the grid was built from the book, the station's offers are the live ones
+            auto stationOffers = entry->station->getMarketOffers();
+            wares::Offer stationOffer;
+
+            if (type == wares::TradeType::Buy)
+            {
+                stationOffer = stationOffers.buyOffers.get(ware);
+                if (stationOffer.price < ownerOffer.price)
+                    continue;
+            }
+            else
+            {
+                stationOffer = stationOffers.sellOffers.get(ware);
+                if (stationOffer.price > ownerOffer.price)
+                    continue;
+            }
+
+            int quantity = std::min({ownerOffer.quantity, stationOffer.quantity, cargoCapacity});
+
+            // the ship first flies to wherever it loads the wares, then between the owner and the station
+            vec2f firstStop = type == wares::TradeType::Buy ? ownerPosition : entry->position;
+            float tripLength = shipPosition.dist(firstStop) + ownerPosition.dist(entry->position);
+            float margin = std::abs(stationOffer.price - ownerOffer.price) / maxPrice;
+
+            float score = quantity * (1.0f + margin) / (tripLength + TRADE_ASSIGNMENT_DISTANCE_BIAS);
+
+            candidates.push_back({score, shipIndex, idle.ship->getId(), entry->id, entry->station, type, ware, quantity});
+            found++;
+        }
+    }
+}
+
+bool TradeAssigner::isStillOpen(const Candidate &candidate) const
+{
+    auto ownerOffers = m_IdleShips[candidate.shipIndex].owner->getMarketOffers();
+    auto stationOffers = candidate.station->getMarketOffers();
+    uint32_t bit = 1u << static_cast<uint32_t>(candidate.ware);
+
+    if (candidate.type == wares::TradeType::Buy)
+    {
+        return (ownerOffers.openSellOffers & bit) != 0 && (stationOffers.openBuyOffers & bit) != 0 &&
+               stationOffers.buyOffers.get(candidate.ware).price >= ownerOffers.sellOffers.get(candidate.ware).price;
+    }
+
+    return (ownerOffers.openBuyOffers & bit) != 0 && (stationOffers.openSellOffers & bit) != 0 &&
+           stationOffers.sellOffers.get(candidate.ware).price <= ownerOffers.buyOffers.get(candidate.ware).price;
+}
+
+TradeAssignmentResult TradeAssigner::assign(EntityManager &entityManager, ThreadPool &threadPool)
+{
+    PROFILE_ZONE("TradeAssigner::assign");
+
+    TradeAssignmentResult result;
+
+    m_IdleShips.clear();
+    for (auto &ship : entityManager.getShips())
+    {
+        if (!ship->isIdle())
+            continue;
+
+        // the owner may have been removed, the ship is stranded then
+        Station *owner = entityManager.getStation(ship->getOwner());
+        if (owner != nullptr)
+        {
+            m_IdleShips.push_back({ship.get(), owner});
+        }
+    }
+
+    result.idleShips = m_IdleShips.size();
+    if (m_IdleShips.empty())
+        return result;
+
+    // nothing changes until the trades are committed, so the grids and then the ships can be
+    // worked on in parallel
+    {
+        PROFILE_ZONE("TradeAssigner offer grids");
+
+        m_BuyOffers.resize(wares::WARE_COUNT);
+        m_SellOffers.resize(wares::WARE_COUNT);
+        threadPool.parallelFor(2 * wares::WARE_COUNT, [&](size_t begin, size_t end, size_t)
+                               {
+            for (size_t i = begin; i < end; i++)
+            {
+                auto ware = static_cast<wares::Ware>(i / 2);
+                if (i % 2 == 0)
+                    buildOfferGrid(entityManager, ware, wares::TradeType::Buy, m_BuyOffers[i / 2]);
+                else
+                    buildOfferGrid(entityManager, ware, wares::TradeType::Sell, m_SellOffers[i / 2]);
+            } });
+    }
+
+    {
+        PROFILE_ZONE("TradeAssigner candidates");
+
+        // cleared up front, a chunk without ships isn't called at all
+        m_CandidatesByChunk.resize(threadPool.getThreadCount());
+        for (auto &candidates : m_CandidatesByChunk)
+        {
+            candidates.clear();
+        }
+
+        threadPool.parallelFor(m_IdleShips.size(), [&](size_t begin, size_t end, size_t chunk)
+                               {
+            auto &candidates = m_CandidatesByChunk[chunk];
+            for (size_t i = begin; i < end; i++)
+            {
+                collectCandidates(i, candidates);
+            } });
+    }
+
+    m_Candidates.clear();
+    for (auto &candidates : m_CandidatesByChunk)
+    {
+        m_Candidates.insert(m_Candidates.end(), candidates.begin(), candidates.end());
+    }
+    result.candidates = m_Candidates.size();
+
+    // best first, ties broken by ids so the result doesn't depend on the thread count
+    std::sort(m_Candidates.begin(), m_Candidates.end(), [&](const Candidate &a, const Candidate &b)
+              {
+        if (a.score != b.score)
+            return a.score > b.score;
+        if (a.shipId != b.shipId)
+            return a.shipId < b.shipId;
+        if (a.stationId != b.stationId)
+            return a.stationId < b.stationId;
+        return a.ware < b.ware; });
+
+    // committing reserves the wares right away, so once an offer is used up the candidates after it
+    // that need the same offer fail validation in commitTrade and the ship moves on to its next best
+    std::vector<bool> assigned(m_IdleShips.size(), false);
+
+    for (auto &candidate : m_Candidates)
+    {
+        if (assigned[candidate.shipIndex])
+            continue;
+
+        // most candidates lost their offer to a better scored one, skip those without going
+        // through a whole proposal
+        if (!isStillOpen(candidate))
+            continue;
+
+        Ship *ship = m_IdleShips[candidate.shipIndex].ship;
+        TradeProposal proposal{candidate.station->getHandle(), {{candidate.type, candidate.ware}}};
+
+        if (!ship->commitTrade(std::move(proposal)))
+            continue;
+
+        assigned[candidate.shipIndex] = true;
+        result.assigned++;
+    }
+
+    metrics::tradesAssigned.add(result.assigned);
+
+    return result;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "spatialGrid.hpp"
+#include "wares.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+class EntityManager;
+class Ship;
+class Station;
+class ThreadPool;
+
+// How often (in simulated seconds) idle ships get trades assigned when batch assignment is on
+#define TRADE_ASSIGNMENT_INTERVAL 2.0f
+// Candidate stations kept per ship and ware
+#define TRADE_ASSIGNMENT_CANDIDATES 8
+// Offers visited per ship and ware while looking for candidates, so an owner priced out of the
+// market doesn't walk every offer of the ware
+#define TRADE_ASSIGNMENT_SEARCH_LIMIT 64
+// Added to every trip length when scoring, so a trip next door doesn't get an unbounded score
+#define TRADE_ASSIGNMENT_DISTANCE_BIAS 1000.0f
+
+struct TradeAssignmentResult
+{
+    size_t idleShips = 0;
+    size_t candidates = 0;
+    size_t assigned = 0;
+};
+
+// Assigns trades to all idle ships at once, instead of every ship grabbing the first trade it
+// finds on its own schedule. Each run has three steps:
+//
+// 1. The open offers of every ware are taken from the OrderBook and put into a spatial grid per
+//    ware and side, sized so a cell holds about as many offers as a cell of the station grid
+//    holds stations. O(offers), in parallel over the grids.
+// 2. Every idle ship looks for up to TRADE_ASSIGNMENT_CANDIDATES counter offers near its owner in
+//    those grids, for each ware its owner has an open offer for. The grids only hold offers of the
+//    right ware and side, so nearly every offer visited is a candidate. Candidates are scored by
+//    quantity and margin per distance travelled. O(idle ships * wares * candidates), in parallel
+//    over the ships.
+// 3. The candidates are sorted and handed out greedily, best score first, with every ship getting
+//    at most one trade and every offer's quantity only being sold once. That's a greedy matching
+//    rather than an optimal assignment, it keeps two ships from racing for the same offer and
+//    spreads the fleet over the market. O(C log C) for C candidates, serial.
+//
+// Each assignment goes through Ship::commitTrade, so it's validated like any other trade.
+class TradeAssigner
+{
+public:
+    TradeAssignmentResult assign(EntityManager &entityManager, ThreadPool &threadPool);
+
+private:
+    struct IdleShip
+    {
+        Ship *ship;
+        Station *owner;
+    };
+
+    struct Candidate
+    {
+        float score;
+        size_t shipIndex;
+        // copied here so sorting doesn't have to chase the pointers
+        int shipId;
+        int stationId;
+        Station *station;
+        wares::TradeType type;
+        wares::Ware ware;
+        int quantity;
+    };
+
+    // Open offers of one ware and side, with the best price among them
+    struct OfferGrid
+    {
+        SpatialGrid grid = SpatialGrid(STATION_GRID_CELL_SIZE);
+        std::optional<float> bestPrice;
+    };
+
+    void buildOfferGrid(const EntityManager &entityManager, wares::Ware ware, wares::TradeType type, OfferGrid &offers) const;
+    void collectCandidates(size_t shipIndex, std::vector<Candidate> &candidates) const;
+    // Whether both offers of a candidate are still open at matching prices
+    bool isStillOpen(const Candidate &candidate) const;
+
+    // reused between runs
+    std::vector<IdleShip> m_IdleShips;
+    // indexed by ware, the buy and the sell offers
+    std::vector<OfferGrid> m_BuyOffers;
+    std::vector<OfferGrid> m_SellOffers;
+    std::vector<std::vector<Candidate>> m_CandidatesByChunk;
+    std::vector<Candidate> m_Candidates;
+};
@@ -5,124 +5,61 @@
 #include "station.hpp"
 #include "wares.hpp"
 #include "warfStation.hpp"
-
-#include <SDL2/SDL.h>
+#include "metrics.hpp"
 
 #include <iostream>
 #include <algorithm>
-#include <random>
-#include <map>
 #include <memory>
 
-int utils::generateId()
+void shipPurchaseCheck(std::shared_ptr<EntityManager> entityManager)
 {
-    static int generatedId = 0;
-    return generatedId++;
-}
+    // the order book keeps the totals per ware up to date, so this only has to look at each ware once
+    auto &orderBook = entityManager->getOrderBook();
 
-std::random_device utils::rd;
-std::mt19937 utils::gen(utils::rd());
-
-struct MaxSellBuyOffersQuantities
-{
-    int maxSellQuantity = 0;
-    int maxBuyQuantity = 0;
+    long long tradeVolume = 0;
+    Ware highestVolumeWare = Ware::HullParts;
 
-    int totalSellQuantity = 0;
-    int totalBuyQuantity = 0;
-
-    std::shared_ptr<Station> seller = nullptr;
-    std::shared_ptr<Station> buyer = nullptr;
-};
-
-void shipPurchaseCheck(std::shared_ptr<EntityManager> entityManager, Uint64 &lastTradeVolumeCheck)
-{
-    lastTradeVolumeCheck = SDL_GetPerformanceCounter();
-
-    std::map<Ware, MaxSellBuyOffersQuantities> maxGlobalSellBuyOffers;
-
-    for (auto station : entityManager->getStations())
+    for (size_t i = 0; i < wares::WARE_COUNT; i++)
     {
-        auto &sellOffers = station->getSellOffers();
+        Ware ware = static_cast<Ware>(i);
+        long long volume = std::min(orderBook[ware].getTotalQuantity(wares::TradeType::Sell), orderBook[ware].getTotalQuantity(wares::TradeType::Buy));
 
-        for (auto &sellOffer : sellOffers)
+        if (volume > tradeVolume)
         {
-            if (maxGlobalSellBuyOffers.find(sellOffer.first) == maxGlobalSellBuyOffers.end())
-            {
-                MaxSellBuyOffersQuantities maxSellBuyOffersQuantities{sellOffer.second.quantity, 0, sellOffer.second.quantity, 0, station, nullptr};
-                maxGlobalSellBuyOffers[sellOffer.first] = maxSellBuyOffersQuantities;
-                continue;
-            }
-
-            maxGlobalSellBuyOffers[sellOffer.first].totalSellQuantity += sellOffer.second.quantity;
-
-            if (sellOffer.second.quantity > maxGlobalSellBuyOffers[sellOffer.first].maxSellQuantity)
-            {
-                maxGlobalSellBuyOffers[sellOffer.first].maxSellQuantity = sellOffer.second.quantity;
-                maxGlobalSellBuyOffers[sellOffer.first].seller = station;
-            }
-        }
-
-        auto &buyOffers = station->getBuyOffers();
-
-        for (auto buyOffer : buyOffers)
-        {
-            if (maxGlobalSellBuyOffers.find(buyOffer.first) == maxGlobalSellBuyOffers.end())
-            {
-                MaxSellBuyOffersQuantities maxSellBuyOffersQuantities{0, buyOffer.second.quantity, 0, buyOffer.second.quantity, nullptr, station};
-
-                maxGlobalSellBuyOffers[buyOffer.first] = maxSellBuyOffersQuantities;
-                continue;
-            }
-
-            maxGlobalSellBuyOffers[buyOffer.first].totalBuyQuantity += buyOffer.second.quantity;
-
-            if (buyOffer.second.quantity > maxGlobalSellBuyOffers[buyOffer.first].maxBuyQuantity)
-            {
-                maxGlobalSellBuyOffers[buyOffer.first].maxBuyQuantity = buyOffer.second.quantity;
-                maxGlobalSellBuyOffers[buyOffer.first].buyer = station;
-            }
+            tradeVolume = volume;
+            highestVolumeWare = ware;
         }
     }
 
-    auto biggestTradeVolume = std::max_element(maxGlobalSellBuyOffers.begin(), maxGlobalSellBuyOffers.end(), [](const auto &a, const auto &b)
-                                               { return std::min(a.second.totalSellQuantity, a.second.totalBuyQuantity) < std::min(b.second.totalSellQuantity, b.second.totalBuyQuantity); });
-
-    int tradeVolume = std::min(biggestTradeVolume->second.totalSellQuantity, biggestTradeVolume->second.totalBuyQuantity);
-
     // if there is not enough trade volume, don't do anything
     if (tradeVolume < 500)
         return;
 
-    Ware highestVolumeWare = biggestTradeVolume->first;
-    std::shared_ptr<Station> station;
+    auto &book = orderBook[highestVolumeWare];
 
-    if (biggestTradeVolume->second.totalSellQuantity > biggestTradeVolume->second.totalBuyQuantity)
-    {
-        station = biggestTradeVolume->second.buyer;
-    }
-    else
-    {
-        station = biggestTradeVolume->second.seller;
-    }
+    // the side with less quantity gets the ship
+    auto type = book.getTotalQuantity(wares::TradeType::Sell) > book.getTotalQuantity(wares::TradeType::Buy) ? wares::TradeType::Buy : wares::TradeType::Sell;
+    auto largestOffer = book.getLargestOffer(type);
 
-    if (!station)
+    if (!largestOffer.has_value())
         return;
 
+    Station *station = largestOffer->station;
+
     // add one ship to the station
     ShipConstructionOrder order;
     order.cargoCapacity = 100;
     order.maxSpeed = 600;
-    order.ownerID = station->getId();
+    order.owner = station->getHandle();
     order.timeToConstruct = 10;
     order.weaponAttack = 1.0;
 
     auto &warfStations = entityManager->getWarfStations();
 
     // DON'T DO THIS
-    if (!warfStations[0]->doesStationHaveAOrderInQueue(station->getId()))
+    if (!warfStations[0]->doesStationHaveAOrderInQueue(station->getHandle()))
     {
-        printf("Ordering ship for station %s\n", station->getName().c_str());
         warfStations[0]->orderShip(order);
+        metrics::shipOrdersPlaced.add();
     }
 }
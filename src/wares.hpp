@@ -1,16 +1,20 @@
 #pragma once
 
-#include <map>
 #include <string>
 #include <memory>
 #include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
 
-class Station;
+#include "slotMap.hpp"
 
 namespace wares
 {
 
-    enum Ware
+    // one byte, so orders stay small (see OrderQueue)
+    enum Ware : uint8_t
     {
         HullParts,
         EnergyCells,
@@ -19,6 +23,181 @@ namespace wares
         Silicon,
     };
 
+    // Number of wares, for tables indexed by ware
+    const size_t WARE_COUNT = static_cast<size_t>(Silicon) + 1;
+
+    // Index of the lowest set bit, mask must not be 0. Bit n of a ware mask is Ware n.
+    inline size_t lowestBitIndex(uint32_t mask)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<size_t>(__builtin_ctz(mask));
+#else
+        size_t index = 0;
+        while ((mask & 1u) == 0)
+        {
+            mask >>= 1;
+            index++;
+        }
+        return index;
+#endif
+    }
+
+    // Fixed-size table with one slot per ware and a bit per slot telling whether the ware is in it.
+    // Works like a std::map<Ware, T> (same iteration order, operator[] inserts, at() throws), but
+    // lookups are indexed loads and nothing is allocated. Absent slots hold a default T.
+    template <typename T>
+    class WareArray
+    {
+    public:
+        typedef std::pair<Ware, T> value_type;
+
+        static_assert(WARE_COUNT <= 32, "presence bits don't fit in 32 bits");
+
+        template <typename Entries, typename Value>
+        class Iterator
+        {
+        public:
+            Iterator(Entries *entries, uint32_t remaining) : m_Entries(entries), m_Remaining(remaining) {}
+
+            Value &operator*() const
+            {
+                return (*m_Entries)[lowestBitIndex(m_Remaining)];
+            }
+            Value *operator->() const
+            {
+                return &**this;
+            }
+            Iterator &operator++()
+            {
+                m_Remaining &= m_Remaining - 1;
+                return *this;
+            }
+            bool operator==(const Iterator &other) const
+            {
+                return m_Remaining == other.m_Remaining;
+            }
+            bool operator!=(const Iterator &other) const
+            {
+                return m_Remaining != other.m_Remaining;
+            }
+
+        private:
+            Entries *m_Entries;
+            uint32_t m_Remaining;
+        };
+
+        typedef Iterator<std::array<value_type, WARE_COUNT>, value_type> iterator;
+        typedef Iterator<const std::array<value_type, WARE_COUNT>, const value_type> const_iterator;
+
+        WareArray()
+        {
+            for (size_t i = 0; i < WARE_COUNT; i++)
+            {
+                m_Entries[i] = {static_cast<Ware>(i), T{}};
+            }
+        }
+
+        WareArray(std::initializer_list<value_type> entries) : WareArray()
+        {
+            for (auto &entry : entries)
+            {
+                (*this)[entry.first] = entry.second;
+            }
+        }
+
+        bool contains(Ware ware) const
+        {
+            return (m_Present & bit(ware)) != 0;
+        }
+
+        // Inserts a default T if the ware isn't in the table yet
+        T &operator[](Ware ware)
+        {
+            m_Present |= bit(ware);
+            return m_Entries[ware].second;
+        }
+
+        T &at(Ware ware)
+        {
+            if (!contains(ware))
+                throw std::out_of_range("WareArray::at");
+            return m_Entries[ware].second;
+        }
+        const T &at(Ware ware) const
+        {
+            if (!contains(ware))
+                throw std::out_of_range("WareArray::at");
+            return m_Entries[ware].second;
+        }
+
+        // The value for a ware, or a default T if it isn't in the table. Doesn't insert.
+        const T &get(Ware ware) const
+        {
+            return m_Entries[ware].second;
+        }
+
+        void erase(Ware ware)
+        {
+            m_Present &= ~bit(ware);
+            m_Entries[ware].second = T{};
+        }
+
+        // One bit per ware in the table, bit n is Ware n
+        uint32_t getPresenceMask() const
+        {
+            return m_Present;
+        }
+
+        size_t size() const
+        {
+            size_t count = 0;
+            for (uint32_t remaining = m_Present; remaining != 0; remaining &= remaining - 1)
+            {
+                count++;
+            }
+            return count;
+        }
+        bool empty() const
+        {
+            return m_Present == 0;
+        }
+
+        iterator find(Ware ware)
+        {
+            return contains(ware) ? iterator(&m_Entries, m_Present & ~(bit(ware) - 1)) : end();
+        }
+        const_iterator find(Ware ware) const
+        {
+            return contains(ware) ? const_iterator(&m_Entries, m_Present & ~(bit(ware) - 1)) : end();
+        }
+
+        iterator begin()
+        {
+            return iterator(&m_Entries, m_Present);
+        }
+        iterator end()
+        {
+            return iterator(&m_Entries, 0);
+        }
+        const_iterator begin() const
+        {
+            return const_iterator(&m_Entries, m_Present);
+        }
+        const_iterator end() const
+        {
+            return const_iterator(&m_Entries, 0);
+        }
+
+    private:
+        static uint32_t bit(Ware ware)
+        {
+            return 1u << static_cast<uint32_t>(ware);
+        }
+
+        std::array<value_type, WARE_COUNT> m_Entries;
+        uint32_t m_Present = 0;
+    };
+
     struct WareDetails
     {
         float density;
@@ -27,7 +206,7 @@ namespace wares
         std::string name;
     };
 
-    const std::map<Ware, WareDetails> wareDetails = {
+    const WareArray<WareDetails> wareDetails = {
         {HullParts, {1.0, 10.0, 20.0, "Hull Parts"}},
         {EnergyCells, {0.5, 5.0, 10.0, "Energy Cells"}},
         {Ore, {2.0, 1.0, 2.0, "Ore"}},
@@ -35,7 +214,7 @@ namespace wares
         {Silicon, {0.5, 1.0, 5.0, "Silicon"}},
     };
 
-    enum class TradeType
+    enum class TradeType : uint8_t
     {
         Buy,
         Sell
@@ -47,6 +226,16 @@ namespace wares
         int quantity;
     };
 
+    // A station's offers plus masks of the wares with an open (quantity > 0) buy or sell offer, so
+    // matching two stations' offers starts with a couple of ANDs instead of lookups per ware
+    struct MarketOffers
+    {
+        const WareArray<Offer> &buyOffers;
+        const WareArray<Offer> &sellOffers;
+        uint32_t openBuyOffers;
+        uint32_t openSellOffers;
+    };
+
     struct WareQuantity
     {
         Ware ware;
@@ -55,7 +244,7 @@ namespace wares
 
     struct ShipOrder
     {
-        std::shared_ptr<Station> station;
+        StationHandle station;
         float maxSpeed;
         float cargoCapacity;
         float weaponAttack;
@@ -7,33 +7,43 @@
 
 void WarfStation::orderShip(ShipConstructionOrder order)
 {
+    order.id = this->m_NextOrderId++;
+    order.underConstruction = false;
     this->shipConstructors.push_back(order);
 }
 
-void WarfStation::tick(float dt)
+void WarfStation::startConstruction()
 {
     // first 5 ships in the queue are constructed
     for (size_t i = 0; i < 5 && i < this->shipConstructors.size(); i++)
     {
-
         auto &order = this->shipConstructors[i];
 
-        if (order.halted)
+        if (order.halted || order.underConstruction)
             continue;
 
-        order.timeToConstruct -= dt;
+        order.underConstruction = true;
+        this->scheduleTimer(order.timeToConstruct, order.id);
+    }
+}
 
-        if (order.timeToConstruct <= 0)
-        {
-            auto ship = std::make_shared<Ship>(this->getPosition(), order.maxSpeed, order.cargoCapacity, order.weaponAttack, this->m_Renderer);
-            ship->claim(m_Manager->getStationById(order.ownerID));
+void WarfStation::onTimer(uint32_t id, CommandBuffer &commands)
+{
+    for (size_t i = 0; i < this->shipConstructors.size(); i++)
+    {
+        auto &order = this->shipConstructors[i];
 
-            this->m_Manager->addShip(ship);
+        if (order.id != id)
+            continue;
 
-            this->shipConstructors.erase(this->shipConstructors.begin() + i);
-            i--;
-        }
+        commands.spawnShip({this->getPosition(), order.maxSpeed, order.cargoCapacity, order.weaponAttack, order.owner, this->m_Renderer});
+
+        this->shipConstructors.erase(this->shipConstructors.begin() + i);
+        break;
     }
+
+    // the next order in the queue moves up
+    this->startConstruction();
 }
 
 void WarfStation::postUpdateInventory()
@@ -49,7 +59,7 @@ void WarfStation::postUpdateInventory()
 
         for (auto &inputWare : wares::shipConstructionCost)
         {
-            if (this->inventory[inputWare.ware] < inputWare.quantity)
+            if (market().inventory[inputWare.ware] < inputWare.quantity)
             {
                 order.halted = true;
                 break;
@@ -64,13 +74,15 @@ void WarfStation::postUpdateInventory()
             this->updateInventory(inputWare.ware, -inputWare.quantity);
         }
     }
+
+    this->startConstruction();
 }
 
-bool WarfStation::doesStationHaveAOrderInQueue(int stationID)
+bool WarfStation::doesStationHaveAOrderInQueue(StationHandle station)
 {
     for (auto &order : this->shipConstructors)
     {
-        if (order.ownerID == stationID)
+        if (order.owner == station)
         {
             return true;
         }
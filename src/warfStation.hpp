@@ -4,7 +4,7 @@
 
 struct ShipConstructionOrder
 {
-    int ownerID;
+    StationHandle owner;
 
     float maxSpeed;
     float cargoCapacity;
@@ -12,6 +12,10 @@ struct ShipConstructionOrder
     float timeToConstruct;
 
     bool halted = true;
+
+    // set by the WarfStation
+    uint32_t id = 0;
+    bool underConstruction = false;
 };
 
 class WarfStation : public Station
@@ -19,13 +23,17 @@ class WarfStation : public Station
 public:
     using Station::Station;
 
-    void tick(float dt) override;
+    // The timer id is the id of the order whose ship is finished
+    void onTimer(uint32_t id, CommandBuffer &commands) override;
     void orderShip(ShipConstructionOrder order);
 
-    bool doesStationHaveAOrderInQueue(int stationID);
+    bool doesStationHaveAOrderInQueue(StationHandle station);
 
 private:
     std::vector<ShipConstructionOrder> shipConstructors;
+    uint32_t m_NextOrderId = 0;
 
     void postUpdateInventory() override;
+    // Starts the timers of the orders that can be worked on now
+    void startConstruction();
 };
\ No newline at end of file